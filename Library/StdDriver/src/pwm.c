@@ -122,7 +122,7 @@ void PWM0_DeadZoneEnable(uint8_t u8PWM0Pair, uint16_t u16PWM0DZValue)
 {
     SFRS = 0x01;
     BYTE_TMP = 0;
-    BYTE_TMP |= u16PWM0DZValue&0x0100>>4;
+    BYTE_TMP |= (u16PWM0DZValue&0x0100)>>4;
     switch (u8PWM0Pair)
     {
         case PWM0_CH01:  BYTE_TMP|=0x01; break;
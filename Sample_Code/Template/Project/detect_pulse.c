@@ -4,15 +4,40 @@
 #include "numicro_8051.h"
 
 #include "detect_pulse.h"
+#include "duty_curve.h"
+#include "freq_meter.h"
+#include "pwm_ctrl.h"
+#include "timebase.h"
 
 /*_____ D E C L A R A T I O N S ____________________________________________*/
 
 /*_____ D E F I N I T I O N S ______________________________________________*/
 volatile OUTPUT_PULSE_MANAGER_T g_OutputPulseManager = 
 {
-    100U,   /* duty_resolution */
-    50U,    /* duty_percent default 50% */
-    50U,    /* duty_latched  */
+    DUTY_RESOLUTION_HI,/* duty_resolution : 0.01 % */
+    5000U,  /* duty_percent default 50% */
+    {{5000U, 5000U}, {5000U, 5000U}},/* duty_stage */
+    0U,     /* stage_idx     */
+    {5000U, 5000U},/* duty_target */
+    {5000U, 5000U},/* duty_ramp  */
+    DETECT_SLEW_STEP_DEFAULT,/* slew_step */
+    0U,     /* window_seq    */
+    0U,     /* slew_seq      */
+#if defined (ENABLE_DETECT_FULL_WAVE)
+    {1U, 1U},/* half_enable  */
+#else
+    {1U, 0U},/* half_enable  */
+#endif
+    {{0U, 0U}, {0U, 0U}},/* on_stage */
+    {0U, 0U},/* stage_gen    */
+    {0UL, 0UL},/* duty_recip  */
+    0U,     /* recip_gen     */
+    0U,     /* prov_win      */
+    DETECT_OUTPUT_MODE_DEFAULT,/* output_mode */
+    DETECT_OUTPUT_MODE_DEFAULT,/* mode_latched */
+    {{0U, 1U, 1U}, {0U, 1U, 1U}},/* burst_stage */
+    0U,     /* burst_idx     */
+    5000U,  /* duty_latched  */
     0U,     /* mode0         */
     0U      /* mode100       */
 };
@@ -26,18 +51,177 @@ volatile DETECT_PULSE_MANAGER_T g_DetectPulseManager =
     0U,               /* duty_start_tick */
     0U,               /* pending_start_tick */
     0U,               /* high_ticks */
+    {0U, 0U},         /* on_hold */
+    0U,               /* delay_ticks */
+    0U,               /* burst_phase */
+    0U,               /* burst_width */
+    0U,               /* burst_gap */
+    0U,               /* burst_left */
+    0U,               /* burst_level */
     0U,               /* last_low_ticks */
     0U,               /* fixed_low_ticks */
     0xFFFFU,          /* min_low */
     0U,               /* max_low */
     0U,               /* sample_cnt */
     0U,               /* calib_done */
-    1U                /* prev_input_state (assume idle HIGH) */
+    1U,               /* prev_input_state (assume idle HIGH) */
+    0U,               /* reset_req_seq */
+    0U,               /* reset_ack_seq */
+    PERIOD_MIN_TICKS, /* period_min_ticks */
+    PERIOD_MAX_TICKS, /* period_max_ticks */
+#if defined (ENABLE_DETECT_AUTO_RANGE)
+    AUTO_RANGE_LEARNING,/* range_state */
+#else
+    AUTO_RANGE_LOCKED,/* range_state */
+#endif
+    0U,               /* learn_cnt */
+    0U,               /* recal_pending */
+    DETECT_LOS_TIMEOUT_TICKS,/* los_countdown */
+    0U,               /* los_active */
+    DETECT_FAILSAFE_LEVEL,/* failsafe_level */
+    0U,               /* drift_cnt */
+    0U,               /* fly_period_q4 */
+    0U,               /* fly_period_ticks */
+    0U,               /* fly_ref_tick */
+    0U,               /* fly_ref_valid */
+    0U,               /* fly_miss_cnt */
+    DETECT_FLYWHEEL_MAX_MISS,/* fly_max_miss */
+    0xFFU,            /* filt_shift (idle HIGH) */
+    DETECT_FILTER_INTEG_MAX,/* filt_integ */
+    1U,               /* filt_state */
+    0U,               /* high_start_tick */
+    0U,               /* high_start_valid */
+    0U,               /* high_half_req */
+    0U,               /* high_half_active */
+    0UL,              /* sum_high */
+    0xFFFFU,          /* min_high */
+    0U,               /* max_high */
+    0U,               /* high_sample_cnt */
+    0U,               /* high_calib_done */
+    0U,               /* last_high_ticks */
+    0U,               /* fixed_high_ticks */
+    1U,               /* calib_gen */
+    0U,               /* span_start_tick */
+    0U,               /* span_count */
+    0U,               /* span_active */
+    0U,               /* span_ticks */
+    0U,               /* span_periods */
+    0U                /* span_seq */
+};
+
+volatile DETECT_METRICS_T g_DetectMetrics = 
+{
+    0U,               /* seq */
+    0U,               /* windows */
+    0U,               /* calibrations */
+    0U,               /* noise_reject */
+    0U,               /* too_short */
+    0U,               /* out_of_range */
+    0U,               /* los_events */
+    0U,               /* los_recover */
+    0U,               /* drift_recal */
+    0U,               /* fly_missed */
+    0U,               /* fly_synth */
+    0U,               /* fly_resync */
+    0U,               /* filt_reject */
+    0U                /* filt_glitch */
+};
+
+volatile DETECT_STATS_T g_DetectStats = 
+{
+    0U,               /* seq */
+    0U,               /* clear_req */
+    0U,               /* n */
+    0xFFFFU,          /* min */
+    0U,               /* max */
+    0UL,              /* sum */
+    0UL               /* sumsq */
+};
+
+#if defined (ENABLE_DETECT_STATS)
+/* persistent LOW width histogram, saturating counts */
+static unsigned int xdata detect_stats_hist[DETECT_STATS_BINS];
+#endif
 
+#if defined (ENABLE_DETECT_AUTO_RANGE)
+/* LOW width histogram for the startup learning phase */
+static unsigned char xdata auto_range_hist[AUTO_RANGE_BINS];
+#endif
+
+volatile DETECT_TRACE_T g_DetectTrace = 
+{
+    0U,               /* head */
+    0U,               /* count */
+    0U,               /* frozen */
+    1U,               /* armed */
+    DETECT_TRACE_TRIGGER_DEFAULT,/* trigger */
+    0U                /* post_cnt */
 };
 
+#if defined (ENABLE_DETECT_TRACE)
+static DETECT_TRACE_ENTRY_T xdata detect_trace_buf[DETECT_TRACE_SIZE];
+
+/* inline on purpose : used by both the timer and the edge ISR (same priority, never nested),
+   a shared function would be an overlay conflict */
+#define DETECT_TRACE(event) \
+    do { \
+        unsigned char _idx; \
+        if (g_DetectTrace.frozen == 0U) \
+        { \
+            _idx = g_DetectTrace.head; \
+            detect_trace_buf[_idx].tick = g_DetectPulseManager.tick100us; \
+            detect_trace_buf[_idx].sub  = TIMEBASE_SUBTICK(); \
+            detect_trace_buf[_idx].ev   = (event); \
+            g_DetectTrace.head = (_idx + 1U) & (DETECT_TRACE_SIZE - 1U); \
+            if (g_DetectTrace.count < DETECT_TRACE_SIZE) { g_DetectTrace.count++; } \
+            if (g_DetectTrace.post_cnt != 0U) \
+            { \
+                if (--g_DetectTrace.post_cnt == 0U) { g_DetectTrace.frozen = 1U; } \
+            } \
+            else if ((g_DetectTrace.armed != 0U) && ((event) == g_DetectTrace.trigger)) \
+            { \
+                g_DetectTrace.armed    = 0U; \
+                g_DetectTrace.post_cnt = DETECT_TRACE_POST; \
+            } \
+        } \
+    } while (0)
+
+/* P1.5 changes are logged on transitions only, the duty timing rewrites the level every tick */
+#define OUTPUT_PULSE_HIGH \
+    do { if (P15 == 0) { P15 = 1; DETECT_TRACE(DETECT_EV_OUT_RISE); } } while (0)
+#define OUTPUT_PULSE_LOW \
+    do { if (P15 != 0) { P15 = 0; DETECT_TRACE(DETECT_EV_OUT_FALL); } } while (0)
+#else
+#define DETECT_TRACE(event)
 #define OUTPUT_PULSE_HIGH							(P15 = 1)
 #define OUTPUT_PULSE_LOW							(P15 = 0)
+#endif
+
+#if defined (ENABLE_DETECT_FILTER_PROFILE)
+#define DETECT_FILTER_PROFILE_BEGIN					(P13 = 1)
+#define DETECT_FILTER_PROFILE_END					(P13 = 0)
+#else
+#define DETECT_FILTER_PROFILE_BEGIN
+#define DETECT_FILTER_PROFILE_END
+#endif
+
+#if (DETECT_FILTER_TYPE == DETECT_FILTER_MAJORITY)
+/* set bits per nibble, two lookups count the majority window */
+static unsigned char code detect_filter_popcnt4[16] =
+{
+    0U, 1U, 1U, 2U, 1U, 2U, 2U, 3U, 1U, 2U, 2U, 3U, 2U, 3U, 3U, 4U
+};
+
+#define DETECT_FILTER_M_MASK        ((unsigned char)((1U << DETECT_FILTER_M) - 1U))
+#endif
+
+/* new calibration generation, 0 is kept for "on_stage not computed" */
+#define DETECT_CALIB_GEN_BUMP \
+    do { if (++g_DetectPulseManager.calib_gen == 0U) { g_DetectPulseManager.calib_gen = 1U; } } while (0)
+
+/* one saturating counter bump inside the metrics seqlock */
+#define DETECT_METRIC_INC(field) \
+    do { g_DetectMetrics.seq++; if (g_DetectMetrics.field != 0xFFFFU) { g_DetectMetrics.field++; } g_DetectMetrics.seq++; } while (0)
 
 /*_____ M A C R O S ________________________________________________________*/
 
@@ -54,10 +238,9 @@ static unsigned int elapsed_ticks(unsigned int now, unsigned int start)
     return dt;
 }
 
-void Reset_EINT_calibration(void)
+/* ISR side of Reset_EINT_calibration(), only called from output_pulse_irq() */
+static void detect_calibration_clear(void)
 {
-    EA = 0;
-
     g_DetectPulseManager.sum_low            = 0UL;
     g_DetectPulseManager.low_start_tick     = 0U;
     g_DetectPulseManager.duty_start_tick    = 0U;
@@ -71,12 +254,107 @@ void Reset_EINT_calibration(void)
     g_DetectPulseManager.sample_cnt         = 0U;
     g_DetectPulseManager.calib_done         = 0U;
     g_DetectPulseManager.state              = DETECT_STATE_HIGH;
+    DETECT_CALIB_GEN_BUMP;
+
+    g_DetectPulseManager.fly_period_q4      = 0U;
+    g_DetectPulseManager.fly_period_ticks   = 0U;
+    g_DetectPulseManager.fly_ref_valid      = 0U;
+    g_DetectPulseManager.fly_miss_cnt       = 0U;
+
+    g_DetectPulseManager.span_active        = 0U;
+    FREQ_METER_RESTART();
+
+    g_DetectPulseManager.high_start_valid   = 0U;
+    g_DetectPulseManager.high_half_req      = 0U;
+    g_DetectPulseManager.high_half_active   = 0U;
+    g_DetectPulseManager.sum_high           = 0UL;
+    g_DetectPulseManager.min_high           = 0xFFFFU;
+    g_DetectPulseManager.max_high           = 0U;
+    g_DetectPulseManager.high_sample_cnt    = 0U;
+    g_DetectPulseManager.high_calib_done    = 0U;
+    g_DetectPulseManager.last_high_ticks    = 0U;
+    g_DetectPulseManager.fixed_high_ticks   = 0U;
+
+    /* served outside LOW_ACTIVE, which still includes a flywheel window or the HIGH half :
+       end any output pulse in progress so P1.5 is not left HIGH until the next window */
+    g_OutputPulseManager.mode0   = 0U;
+    g_OutputPulseManager.mode100 = 0U;
+    OUTPUT_PULSE_LOW;
+}
+
+/* request only : the 100us ISR serves it between windows (8-bit sequence, no EA=0) */
+void Reset_EINT_calibration(void)
+{
+    g_DetectPulseManager.reset_req_seq++;
+}
+
+/* command -> output duty through the DETECT_DUTY_CURVE table */
+unsigned int Duty_Curve(unsigned int duty)
+{
+#if (DETECT_DUTY_CURVE == DUTY_CURVE_LINEAR)
+    return duty;
+#else
+    unsigned char idx;
+    unsigned char frac;
+    unsigned int a;
+    unsigned int b;
+
+    if (duty >= DUTY_RESOLUTION_HI)
+    {
+        return duty_curve_table[DUTY_CURVE_POINTS - 1U];
+    }
+
+    /* whole percent : one MOVC, else linear between the two table points */
+    idx  = (unsigned char)(duty / 100U);
+    frac = (unsigned char)(duty - ((unsigned int)idx * 100U));
+    a = duty_curve_table[idx];
+    if (frac == 0U)
+    {
+        return a;
+    }
+    b = duty_curve_table[idx + 1U];
+
+    return a + (unsigned int)((((unsigned long)(b - a) * frac) + 50UL) / 100UL);
+#endif
+}
+
+/* duty setter: clamp 0..100, lock-free handoff to ISR */
+/* main loop only : publish both half duties (command -> curve) in the slot ISR is not reading */
+static void detect_duty_publish(unsigned int d_low, unsigned int d_high)
+{
+    unsigned char next;
+
+    d_low  = Duty_Curve(d_low);
+    d_high = Duty_Curve(d_high);
 
-    EA = 1;
+    /* fill the slot ISR is not reading, then publish it with a single byte write ;
+       ISR latches duty_stage[stage_idx][half] at (half) window start */
+    next = g_OutputPulseManager.stage_idx ^ 1U;
+    g_OutputPulseManager.duty_stage[next][DETECT_HALF_LOW]  = d_low;
+    g_OutputPulseManager.duty_stage[next][DETECT_HALF_HIGH] = d_high;
+    g_OutputPulseManager.stage_gen[next] = 0U;  /* Detect_Process() fills on_stage */
+    g_OutputPulseManager.stage_idx = next;
 }
 
-/* duty setter: clamp 0..100, atomic vs ISR */
 void PWM_SetDutyPercent(unsigned int duty_percent_input)
+{
+    if (duty_percent_input > 100U)
+    {
+        duty_percent_input = 100U;
+    }
+    PWM_SetDuty10000(duty_percent_input * 100U);
+}
+
+void PWM_SetHalfDutyPercent(unsigned char half, unsigned int duty_percent_input)
+{
+    if (duty_percent_input > 100U)
+    {
+        duty_percent_input = 100U;
+    }
+    PWM_SetHalfDuty10000(half, duty_percent_input * 100U);
+}
+
+void PWM_SetDuty10000(unsigned int duty_percent_input)
 {
     unsigned int d;
 
@@ -89,224 +367,1429 @@ void PWM_SetDutyPercent(unsigned int duty_percent_input)
         d = duty_percent_input;
     }
 
-    EA = 0;
     g_OutputPulseManager.duty_percent = d;
-    EA = 1;
+    g_OutputPulseManager.duty_target[DETECT_HALF_LOW]  = d;
+    g_OutputPulseManager.duty_target[DETECT_HALF_HIGH] = d;
+
+    if (g_OutputPulseManager.slew_step == 0U)
+    {
+        g_OutputPulseManager.duty_ramp[DETECT_HALF_LOW]  = d;
+        g_OutputPulseManager.duty_ramp[DETECT_HALF_HIGH] = d;
+        detect_duty_publish(d, d);
+    }
+    /* else Detect_Process() ramps duty_ramp toward duty_target window by window */
 }
 
-// Put under timer : 100us irq
-void output_pulse_irq(void)
+void PWM_SetHalfDuty10000(unsigned char half, unsigned int duty_percent_input)
 {
-    unsigned int dt;
-    unsigned int now;
-    unsigned int dt_low;
-    unsigned char curr_input_state;
+    unsigned int d;
 
-    g_DetectPulseManager.tick100us++;
+    if (half > DETECT_HALF_HIGH)
+    {
+        return;
+    }
 
-    curr_input_state = (P17 == 1) ? 1U : 0U;
-    now  = g_DetectPulseManager.tick100us;
+    if (duty_percent_input > g_OutputPulseManager.duty_resolution)
+    {
+        d = g_OutputPulseManager.duty_resolution;
+    }
+    else
+    {
+        d = duty_percent_input;
+    }
 
-    /* 1) handle LOW_PENDING -> LOW_ACTIVE confirmation */
-    if (g_DetectPulseManager.state == DETECT_STATE_LOW_PENDING)
+    if (half == DETECT_HALF_LOW)
     {
-        if (curr_input_state == 0U)
+        g_OutputPulseManager.duty_percent = d;
+    }
+    g_OutputPulseManager.duty_target[half] = d;
+
+    if (g_OutputPulseManager.slew_step == 0U)
+    {
+        /* the other half keeps its value */
+        g_OutputPulseManager.duty_ramp[half] = d;
+        detect_duty_publish(g_OutputPulseManager.duty_ramp[DETECT_HALF_LOW],
+                            g_OutputPulseManager.duty_ramp[DETECT_HALF_HIGH]);
+    }
+}
+
+void PWM_SetSlewStep(unsigned int step)
+{
+    g_OutputPulseManager.slew_step = step;
+    g_OutputPulseManager.slew_seq  = g_OutputPulseManager.window_seq;
+
+    if (step == 0U)
+    {
+        /* limiter off : jump to the targets now */
+        g_OutputPulseManager.duty_ramp[DETECT_HALF_LOW]  = g_OutputPulseManager.duty_target[DETECT_HALF_LOW];
+        g_OutputPulseManager.duty_ramp[DETECT_HALF_HIGH] = g_OutputPulseManager.duty_target[DETECT_HALF_HIGH];
+        detect_duty_publish(g_OutputPulseManager.duty_ramp[DETECT_HALF_LOW],
+                            g_OutputPulseManager.duty_ramp[DETECT_HALF_HIGH]);
+    }
+}
+
+void PWM_SetHalfEnable(unsigned char half, unsigned char enable)
+{
+    if (half <= DETECT_HALF_HIGH)
+    {
+        g_OutputPulseManager.half_enable[half] = (enable != 0U) ? 1U : 0U;
+    }
+}
+
+void PWM_SetOutputMode(unsigned char mode)
+{
+    if ((mode == DETECT_OUTPUT_TRAILING) || (mode == DETECT_OUTPUT_BURST))
+    {
+        g_OutputPulseManager.output_mode = mode;
+    }
+    else
+    {
+        g_OutputPulseManager.output_mode = DETECT_OUTPUT_LEADING;
+    }
+}
+
+void PWM_SetBurst(unsigned char count, unsigned int width, unsigned int gap)
+{
+    unsigned char next;
+
+    /* width / gap at least one tick, a zero countdown would never expire */
+    next = g_OutputPulseManager.burst_idx ^ 1U;
+    g_OutputPulseManager.burst_stage[next].count = count;
+    g_OutputPulseManager.burst_stage[next].width = (width != 0U) ? width : 1U;
+    g_OutputPulseManager.burst_stage[next].gap   = (gap != 0U) ? gap : 1U;
+    g_OutputPulseManager.burst_idx = next;
+}
+
+/* LOW window ended (rising edge) : output off, LOW width statistics and calibration
+ * DETECT_EDGE_MODE_INT1 : called from output_pulse_irq() when the 100us poll sees P1.7 HIGH
+ * DETECT_EDGE_MODE_PIT  : called from input_rise_irq() at the rising edge itself
+ */
+#if defined (ENABLE_DETECT_STATS)
+/* ISR side : one LOW width into the persistent statistics, only called from detect_window_end() */
+static void detect_stats_add(unsigned int dt_low)
+{
+    unsigned char i;
+    unsigned int bin;
+
+    g_DetectStats.seq++;
+
+    if (g_DetectStats.clear_req != 0U)
+    {
+        for (i = 0U; i < DETECT_STATS_BINS; i++)
         {
-            dt = (unsigned int)(now - g_DetectPulseManager.pending_start_tick);
+            detect_stats_hist[i] = 0U;
+        }
+        g_DetectStats.n            = 0U;
+        g_DetectStats.min          = 0xFFFFU;
+        g_DetectStats.max          = 0U;
+        g_DetectStats.sum          = 0UL;
+        g_DetectStats.sumsq        = 0UL;
+        g_DetectStats.clear_req    = 0U;
+    }
 
-            if (dt >= LOW_CONFIRM_TICKS)
-            {
-                /* confirmed LOW window start */
-                g_DetectPulseManager.state           = DETECT_STATE_LOW_ACTIVE;
-                g_DetectPulseManager.low_start_tick  = g_DetectPulseManager.pending_start_tick;
-                g_DetectPulseManager.duty_start_tick = now; /* P1.5 will be HIGH from now */
-
-                /* latch duty at window start */
-                g_OutputPulseManager.duty_latched = g_OutputPulseManager.duty_percent;
-                g_OutputPulseManager.mode0 =
-                    (g_OutputPulseManager.duty_latched == 0U) ? 1U : 0U;
-                g_OutputPulseManager.mode100 =
-                    (g_OutputPulseManager.duty_latched >=
-                     g_OutputPulseManager.duty_resolution) ? 1U : 0U;
-
-                if (g_OutputPulseManager.mode0 != 0U)
-                {
-                    OUTPUT_PULSE_LOW;
-                }
-                else if (g_OutputPulseManager.mode100 != 0U)
-                {
-                    OUTPUT_PULSE_HIGH;
-                }
-                else
-                {
-                    /* 1..99% duty: compute HIGH length (ticks) */
-                    if (g_DetectPulseManager.calib_done != 0U)
-                    {
-                        dt_low = g_DetectPulseManager.fixed_low_ticks;
-                    }
-                    else if (g_DetectPulseManager.last_low_ticks != 0U)
-                    {
-                        dt_low = g_DetectPulseManager.last_low_ticks;
-                    }
-                    else
-                    {
-                        /* default LOW window ~5.0 ms = 50 ticks for first few cycles */
-                        dt_low = 50U;
-                    }
-
-                    g_DetectPulseManager.high_ticks =
-                        (unsigned int)(((unsigned long)dt_low *
-                                        (unsigned long)g_OutputPulseManager.duty_latched) /
-                                       (unsigned long)g_OutputPulseManager.duty_resolution);
-
-                    if (g_DetectPulseManager.high_ticks == 0U)
-                    {
-                        g_DetectPulseManager.high_ticks = 1U;  /* avoid 0 tick HIGH */
-                    }
+    bin = dt_low >> DETECT_STATS_BIN_SHIFT;
+    if (bin >= DETECT_STATS_BINS)
+    {
+        bin = DETECT_STATS_BINS - 1U;
+    }
+    if (detect_stats_hist[bin] != 0xFFFFU)
+    {
+        detect_stats_hist[bin]++;
+    }
 
-                    OUTPUT_PULSE_HIGH;
-                }
-            }
+    if (dt_low >= MIN_LOW_TICKS)
+    {
+        if (dt_low < g_DetectStats.min)
+        {
+            g_DetectStats.min = dt_low;
         }
-        else
+        if (dt_low > g_DetectStats.max)
         {
-            /* pulse returned HIGH before confirmation -> treat as noise */
-            g_DetectPulseManager.state = DETECT_STATE_HIGH;
+            g_DetectStats.max = dt_low;
+        }
+
+        if (dt_low <= DETECT_STATS_MAX_TICKS)
+        {
+            if (g_DetectStats.n >= DETECT_STATS_DECAY_N)
+            {
+                g_DetectStats.n     >>= 1;
+                g_DetectStats.sum   >>= 1;
+                g_DetectStats.sumsq >>= 1;
+            }
+            g_DetectStats.n++;
+            g_DetectStats.sum   += (unsigned long)dt_low;
+            g_DetectStats.sumsq += (unsigned long)dt_low * (unsigned long)dt_low;
         }
     }
 
-    /* 2) handle LOW_ACTIVE window (duty + end-of-window) */
-    if (g_DetectPulseManager.state == DETECT_STATE_LOW_ACTIVE)
+    g_DetectStats.seq++;
+}
+#endif
+
+static void detect_window_end(unsigned int now)
+{
+    unsigned int dt_low;
+    #if defined (ENABLE_DETECT_AUTO_RANGE)
+    unsigned int bin;
+    #endif
+    #if defined (ENABLE_DETECT_SUPERVISOR)
+    unsigned int diff;
+    unsigned char drifted;
+    #endif
+
+    OUTPUT_PULSE_LOW;
+    g_OutputPulseManager.mode0   = 0U;
+    g_OutputPulseManager.mode100 = 0U;
+
+    dt_low = (unsigned int)(now - g_DetectPulseManager.low_start_tick);
+
+    #if defined (ENABLE_DETECT_STATS)
+    detect_stats_add(dt_low);
+    #endif
+
+    DETECT_METRIC_INC(windows);
+    if (dt_low < MIN_LOW_TICKS)
     {
-        if (curr_input_state == 0U)
+        DETECT_METRIC_INC(too_short);
+    }
+    else if ((g_DetectPulseManager.range_state == AUTO_RANGE_LOCKED) &&
+             ((dt_low < g_DetectPulseManager.period_min_ticks) ||
+              (dt_low > g_DetectPulseManager.period_max_ticks)))
+    {
+        DETECT_METRIC_INC(out_of_range);
+    }
+
+    if (dt_low >= MIN_LOW_TICKS)
+    {
+        /* accept as valid LOW window for statistics */
+        g_DetectPulseManager.last_low_ticks = dt_low;
+
+        #if defined (ENABLE_DETECT_AUTO_RANGE)
+        if (g_DetectPulseManager.range_state == AUTO_RANGE_LEARNING)
         {
-            /* still LOW: handle duty timing */
-            if ((g_OutputPulseManager.mode0 == 0U) &&
-                (g_OutputPulseManager.mode100 == 0U))
+            bin = dt_low >> AUTO_RANGE_BIN_SHIFT;
+            if (bin < AUTO_RANGE_BINS)
             {
-                dt = (unsigned int)(now - g_DetectPulseManager.duty_start_tick);
-                if (dt >= g_DetectPulseManager.high_ticks)
+                if (auto_range_hist[bin] != 0xFFU)
                 {
-                    OUTPUT_PULSE_LOW;
+                    auto_range_hist[bin]++;
+                }
+
+                g_DetectPulseManager.learn_cnt++;
+                if (g_DetectPulseManager.learn_cnt >= AUTO_RANGE_LEARN_SAMPLES)
+                {
+                    /* hand the histogram over to Detect_AutoRange_process() */
+                    g_DetectPulseManager.range_state = AUTO_RANGE_READY;
                 }
             }
-            else
+        }
+        #endif
+
+        #if defined (ENABLE_DETECT_SUPERVISOR)
+        /* drift : LOW width away from fixed_low_ticks, or outside the acceptance window */
+        if (g_DetectPulseManager.range_state == AUTO_RANGE_LOCKED)
+        {
+            drifted = 0U;
+            if ((dt_low < g_DetectPulseManager.period_min_ticks) ||
+                (dt_low > g_DetectPulseManager.period_max_ticks))
+            {
+                drifted = 2U;
+            }
+            else if (g_DetectPulseManager.calib_done != 0U)
             {
-                /* mode0 / mode100 force output */
-                if (g_OutputPulseManager.mode0 != 0U)
+                diff = (dt_low > g_DetectPulseManager.fixed_low_ticks) ?
+                       (dt_low - g_DetectPulseManager.fixed_low_ticks) :
+                       (g_DetectPulseManager.fixed_low_ticks - dt_low);
+                if (diff > (g_DetectPulseManager.fixed_low_ticks >> DETECT_DRIFT_SHIFT))
                 {
-                    OUTPUT_PULSE_LOW;
+                    drifted = 1U;
                 }
-                else
+            }
+
+            if (drifted == 0U)
+            {
+                g_DetectPulseManager.drift_cnt = 0U;
+            }
+            else if (++g_DetectPulseManager.drift_cnt >= DETECT_DRIFT_CONFIRM)
+            {
+                g_DetectPulseManager.drift_cnt     = 0U;
+                g_DetectPulseManager.recal_pending = 1U;
+                DETECT_METRIC_INC(drift_recal);
+                DETECT_TRACE(DETECT_EV_RECAL);
+
+                #if defined (ENABLE_DETECT_AUTO_RANGE)
+                if (drifted == 2U)
                 {
-                    OUTPUT_PULSE_HIGH;
+                    /* input jumped out of the learned window : learn it again */
+                    g_DetectPulseManager.range_state = AUTO_RANGE_RESTART;
                 }
+                #endif
             }
         }
-        else
+        #endif
+
+        if ((g_DetectPulseManager.range_state == AUTO_RANGE_LOCKED) &&
+            (dt_low >= g_DetectPulseManager.period_min_ticks) &&
+            (dt_low <= g_DetectPulseManager.period_max_ticks))
         {
-            /* LOW window ended (rising edge) */
-            OUTPUT_PULSE_LOW;
-            g_OutputPulseManager.mode0   = 0U;
-            g_OutputPulseManager.mode100 = 0U;
+            if (g_DetectPulseManager.sample_cnt == 0U)
+            {
+                g_DetectPulseManager.min_low = dt_low;
+                g_DetectPulseManager.max_low = dt_low;
+            }
 
-            dt_low = (unsigned int)(now - g_DetectPulseManager.low_start_tick);
+            g_DetectPulseManager.sum_low += (unsigned long)dt_low;
 
-            if (dt_low >= MIN_LOW_TICKS)
+            if (dt_low < g_DetectPulseManager.min_low)
             {
-                /* accept as valid LOW window for statistics */
-                g_DetectPulseManager.last_low_ticks = dt_low;
-
-                if ((dt_low >= PERIOD_MIN_TICKS) && (dt_low <= PERIOD_MAX_TICKS))
-                {
-                    if (g_DetectPulseManager.sample_cnt == 0U)
-                    {
-                        g_DetectPulseManager.min_low = dt_low;
-                        g_DetectPulseManager.max_low = dt_low;
-                    }
-
-                    g_DetectPulseManager.sum_low += (unsigned long)dt_low;
-
-                    if (dt_low < g_DetectPulseManager.min_low)
-                    {
-                        g_DetectPulseManager.min_low = dt_low;
-                    }
-                    if (dt_low > g_DetectPulseManager.max_low)
-                    {
-                        g_DetectPulseManager.max_low = dt_low;
-                    }
-
-                    g_DetectPulseManager.sample_cnt++;
-                    if (g_DetectPulseManager.sample_cnt >= DETECT_PULSE_SAMPLES)
-                    {
-                        g_DetectPulseManager.sum_low -=
-                            (unsigned long)g_DetectPulseManager.min_low;
-                        g_DetectPulseManager.sum_low -=
-                            (unsigned long)g_DetectPulseManager.max_low;
-
-                        g_DetectPulseManager.fixed_low_ticks =
-                            (unsigned int)(g_DetectPulseManager.sum_low /
-                                           (unsigned long)(DETECT_PULSE_SAMPLES - 2U));
-
-                        g_DetectPulseManager.calib_done = 1U;
-
-                        g_DetectPulseManager.sum_low    = 0UL;
-                        g_DetectPulseManager.sample_cnt = 0U;
-                        g_DetectPulseManager.min_low    = 0xFFFFU;
-                        g_DetectPulseManager.max_low    = 0U;
-                    }
-                }
+                g_DetectPulseManager.min_low = dt_low;
+            }
+            if (dt_low > g_DetectPulseManager.max_low)
+            {
+                g_DetectPulseManager.max_low = dt_low;
             }
 
-            g_DetectPulseManager.state = DETECT_STATE_HIGH;
+            g_DetectPulseManager.sample_cnt++;
+            if (g_DetectPulseManager.sample_cnt >= DETECT_PULSE_SAMPLES)
+            {
+                g_DetectPulseManager.sum_low -=
+                    (unsigned long)g_DetectPulseManager.min_low;
+                g_DetectPulseManager.sum_low -=
+                    (unsigned long)g_DetectPulseManager.max_low;
+
+                g_DetectPulseManager.fixed_low_ticks =
+                    (unsigned int)(g_DetectPulseManager.sum_low /
+                                   (unsigned long)(DETECT_PULSE_SAMPLES - 2U));
+
+                g_DetectPulseManager.calib_done = 1U;
+                DETECT_METRIC_INC(calibrations);
+                DETECT_TRACE(DETECT_EV_CALIB_DONE);
+                DETECT_CALIB_GEN_BUMP;
+
+                g_DetectPulseManager.sum_low    = 0UL;
+                g_DetectPulseManager.sample_cnt = 0U;
+                g_DetectPulseManager.min_low    = 0xFFFFU;
+                g_DetectPulseManager.max_low    = 0U;
+            }
         }
     }
 
-    g_DetectPulseManager.prev_input_state = curr_input_state;
+    #if defined (ENABLE_DETECT_FULL_WAVE)
+    /* HIGH half window starts here, its output is started by the next 100us tick */
+    g_DetectPulseManager.high_start_tick  = now;
+    g_DetectPulseManager.high_start_valid = 1U;
+    g_DetectPulseManager.high_half_req    = 1U;
+    #endif
+
+    g_DetectPulseManager.state = DETECT_STATE_HIGH;
 }
 
-void input_pulse_irq(void)
+/* (half) window start : latch duty and output mode, take P1.5 HIGH length from Detect_Process()
+   (or hold the last one while the slot is refilled), drive P1.5 */
+static void detect_output_begin(unsigned int now, unsigned char half)
 {
-    unsigned int now;
+    unsigned char idx;
+    unsigned int dt_win;
 
-    now = g_DetectPulseManager.tick100us;
+    g_DetectPulseManager.duty_start_tick = now; /* duty timing starts from now */
+    g_OutputPulseManager.window_seq++;          /* slew limiter steps once per (half) window */
 
-    /* only start pending when not already inside a LOW window */
-    if ((g_DetectPulseManager.state == DETECT_STATE_HIGH) && (P17 == 0))
+    /* latch duty at window start, one slot for all reads */
+    idx = g_OutputPulseManager.stage_idx;
+    g_OutputPulseManager.duty_latched = g_OutputPulseManager.duty_stage[idx][half];
+    g_OutputPulseManager.mode_latched = g_OutputPulseManager.output_mode;
+    g_OutputPulseManager.mode0 =
+        ((g_OutputPulseManager.duty_latched == 0U) ||
+         (g_OutputPulseManager.half_enable[half] == 0U)) ? 1U : 0U;
+    g_OutputPulseManager.mode100 =
+        (g_OutputPulseManager.duty_latched >=
+         g_OutputPulseManager.duty_resolution) ? 1U : 0U;
+
+    if (g_OutputPulseManager.mode0 != 0U)
     {
-        g_DetectPulseManager.pending_start_tick = now;
-        g_DetectPulseManager.state = DETECT_STATE_LOW_PENDING;
+        OUTPUT_PULSE_LOW;
+        return;
+    }
+    if (g_OutputPulseManager.mode_latched == DETECT_OUTPUT_BURST)
+    {
+        /* whole schedule latched here, one countdown per tick afterwards whatever the count */
+        g_OutputPulseManager.mode100 = 0U;
+        idx = g_OutputPulseManager.burst_idx;
+        g_DetectPulseManager.burst_left  = g_OutputPulseManager.burst_stage[idx].count;
+        g_DetectPulseManager.burst_width = g_OutputPulseManager.burst_stage[idx].width;
+        g_DetectPulseManager.burst_gap   = g_OutputPulseManager.burst_stage[idx].gap;
+        g_DetectPulseManager.burst_phase = g_DetectPulseManager.burst_width;
+
+        if (g_DetectPulseManager.burst_left != 0U)
+        {
+            g_DetectPulseManager.burst_level = 1U;
+            OUTPUT_PULSE_HIGH;
+        }
+        else
+        {
+            g_DetectPulseManager.burst_level = 0U;
+            OUTPUT_PULSE_LOW;
+        }
+        return;
+    }
+    if (g_OutputPulseManager.mode100 != 0U)
+    {
+        OUTPUT_PULSE_HIGH;
+        return;
+    }
+
+    /* 1..99% duty: window width and HIGH length (ticks) */
+    if (half == DETECT_HALF_HIGH)
+    {
+        /* HIGH half is only started once its width is calibrated */
+        dt_win = g_DetectPulseManager.fixed_high_ticks;
+    }
+    else if (g_DetectPulseManager.calib_done != 0U)
+    {
+        dt_win = g_DetectPulseManager.fixed_low_ticks;
+    }
+    else if (g_DetectPulseManager.last_low_ticks != 0U)
+    {
+        dt_win = g_DetectPulseManager.last_low_ticks;
+    }
+    else
+    {
+        /* default LOW window ~5.0 ms = 50 ticks for first few cycles */
+        dt_win = DEFAULT_LOW_TICKS;
+    }
+
+    if (g_OutputPulseManager.stage_gen[idx] == g_DetectPulseManager.calib_gen)
+    {
+        g_DetectPulseManager.high_ticks = g_OutputPulseManager.on_stage[idx][half];
+        g_DetectPulseManager.on_hold[half] = g_DetectPulseManager.high_ticks;
+    }
+    else
+    {
+        /* duty or calibration just moved, Detect_Process() has not refilled the slot yet :
+           keep this half's last length for one more window, no divide here */
+        g_DetectPulseManager.high_ticks = g_DetectPulseManager.on_hold[half];
+        if (g_DetectPulseManager.high_ticks == 0U)
+        {
+            g_DetectPulseManager.high_ticks = 1U;  /* avoid 0 tick HIGH */
+        }
+    }
+
+    if (g_OutputPulseManager.mode_latched == DETECT_OUTPUT_TRAILING)
+    {
+        /* phase delay : rise so that P1.5 is HIGH for the last high_ticks of the window */
+        g_DetectPulseManager.delay_ticks =
+            (dt_win > g_DetectPulseManager.high_ticks) ? (dt_win - g_DetectPulseManager.high_ticks) : 0U;
+        OUTPUT_PULSE_LOW;
+    }
+    else
+    {
+        OUTPUT_PULSE_HIGH;
     }
 }
 
-void INT1_ISR(void) interrupt 2          // Vector @  0x03
+/* LOW window start (confirmed or synthesized) */
+static void detect_window_begin(unsigned int now, unsigned int start)
 {
-    _push_(SFRS);	
-	
-    input_pulse_irq();
+    g_DetectPulseManager.state          = DETECT_STATE_LOW_ACTIVE;
+    g_DetectPulseManager.low_start_tick = start;
 
-    clr_TCON_IE1;          //clr int flag wait next falling edge
+    #if defined (ENABLE_DETECT_FULL_WAVE)
+    /* HIGH half over (real or synthesized edge), its width is already taken */
+    g_DetectPulseManager.high_half_req    = 0U;
+    g_DetectPulseManager.high_half_active = 0U;
+    g_DetectPulseManager.high_start_valid = 0U;
+    #endif
 
-    _pop_(SFRS);
+    detect_output_begin(now, DETECT_HALF_LOW);
 }
 
-void EINT1_Init(void)
+#if defined (ENABLE_DETECT_FULL_WAVE)
+/* real falling edge confirmed : HIGH half width into its own calibration (trimmed mean, as LOW) */
+static void detect_high_half_end(unsigned int start)
 {
-    /* INT1 pin P1.7 as Quasi mode with internal pull-high */
-    P17_QUASI_MODE;
-    P17 = 1;
-    INT1_FALLING_EDGE_TRIG;             //setting trig condition level or edge
-    set_IE_EX1;                         //INT1_Enable;
-    ENABLE_GLOBAL_INTERRUPT;            //Global interrupt enable
+    unsigned int dt_high;
+    unsigned int diff;
+
+    if (g_DetectPulseManager.high_start_valid == 0U)
+    {
+        return;
+    }
+    g_DetectPulseManager.high_start_valid = 0U;
+
+    dt_high = (unsigned int)(start - g_DetectPulseManager.high_start_tick);
+    if ((dt_high < MIN_LOW_TICKS) || (dt_high > DETECT_HIGH_MAX_TICKS))
+    {
+        return;
+    }
+    g_DetectPulseManager.last_high_ticks = dt_high;
+
+    if (g_DetectPulseManager.high_calib_done != 0U)
+    {
+        /* HIGH width moved (input duty changed) : calibrate it again */
+        diff = (dt_high > g_DetectPulseManager.fixed_high_ticks) ?
+               (dt_high - g_DetectPulseManager.fixed_high_ticks) :
+               (g_DetectPulseManager.fixed_high_ticks - dt_high);
+        if (diff > (g_DetectPulseManager.fixed_high_ticks >> DETECT_DRIFT_SHIFT))
+        {
+            g_DetectPulseManager.high_calib_done = 0U;
+            DETECT_CALIB_GEN_BUMP;
+        }
+        return;
+    }
+
+    if (g_DetectPulseManager.high_sample_cnt == 0U)
+    {
+        g_DetectPulseManager.min_high = dt_high;
+        g_DetectPulseManager.max_high = dt_high;
+    }
+
+    g_DetectPulseManager.sum_high += (unsigned long)dt_high;
+
+    if (dt_high < g_DetectPulseManager.min_high)
+    {
+        g_DetectPulseManager.min_high = dt_high;
+    }
+    if (dt_high > g_DetectPulseManager.max_high)
+    {
+        g_DetectPulseManager.max_high = dt_high;
+    }
+
+    g_DetectPulseManager.high_sample_cnt++;
+    if (g_DetectPulseManager.high_sample_cnt >= DETECT_PULSE_SAMPLES)
+    {
+        g_DetectPulseManager.sum_high -= (unsigned long)g_DetectPulseManager.min_high;
+        g_DetectPulseManager.sum_high -= (unsigned long)g_DetectPulseManager.max_high;
+
+        g_DetectPulseManager.fixed_high_ticks =
+            (unsigned int)(g_DetectPulseManager.sum_high /
+                           (unsigned long)(DETECT_PULSE_SAMPLES - 2U));
+
+        g_DetectPulseManager.high_calib_done = 1U;
+        DETECT_METRIC_INC(calibrations);
+        DETECT_TRACE(DETECT_EV_CALIB_DONE);
+        DETECT_CALIB_GEN_BUMP;
+
+        g_DetectPulseManager.sum_high        = 0UL;
+        g_DetectPulseManager.high_sample_cnt = 0U;
+        g_DetectPulseManager.min_high        = 0xFFFFU;
+        g_DetectPulseManager.max_high        = 0U;
+    }
+}
+#endif
+
+/* inside a window : leading edge ends the HIGH part after high_ticks,
+   trailing edge raises P1.5 after delay_ticks (window end drops it), burst steps one countdown,
+   or hold mode0 / mode100 */
+static void detect_duty_timing(unsigned int now)
+{
+    unsigned int dt;
+
+    if ((g_OutputPulseManager.mode0 == 0U) &&
+        (g_OutputPulseManager.mode100 == 0U))
+    {
+        dt = (unsigned int)(now - g_DetectPulseManager.duty_start_tick);
+        if (g_OutputPulseManager.mode_latched == DETECT_OUTPUT_BURST)
+        {
+            if ((g_DetectPulseManager.burst_left != 0U) &&
+                (--g_DetectPulseManager.burst_phase == 0U))
+            {
+                if (g_DetectPulseManager.burst_level != 0U)
+                {
+                    /* pulse done, gap or end of the train */
+                    OUTPUT_PULSE_LOW;
+                    g_DetectPulseManager.burst_level = 0U;
+                    g_DetectPulseManager.burst_phase = g_DetectPulseManager.burst_gap;
+                    g_DetectPulseManager.burst_left--;
+                }
+                else
+                {
+                    OUTPUT_PULSE_HIGH;
+                    g_DetectPulseManager.burst_level = 1U;
+                    g_DetectPulseManager.burst_phase = g_DetectPulseManager.burst_width;
+                }
+            }
+        }
+        else if (g_OutputPulseManager.mode_latched == DETECT_OUTPUT_TRAILING)
+        {
+            if (dt >= g_DetectPulseManager.delay_ticks)
+            {
+                OUTPUT_PULSE_HIGH;
+            }
+        }
+        else if (dt >= g_DetectPulseManager.high_ticks)
+        {
+            OUTPUT_PULSE_LOW;
+        }
+    }
+    else
+    {
+        /* mode0 / mode100 force output */
+        if (g_OutputPulseManager.mode0 != 0U)
+        {
+            OUTPUT_PULSE_LOW;
+        }
+        else
+        {
+            OUTPUT_PULSE_HIGH;
+        }
+    }
+}
+
+#if defined (ENABLE_DETECT_FLYWHEEL)
+/* real window start : track the fall-to-fall period and resync the flywheel reference */
+static void detect_flywheel_sync(unsigned int start)
+{
+    unsigned int p;
+    unsigned int p_q4;
+    unsigned int period;
+
+    if ((g_DetectPulseManager.fly_ref_valid != 0U) &&
+        (g_DetectPulseManager.fly_miss_cnt == 0U) &&
+        (g_DetectPulseManager.calib_done != 0U))
+    {
+        /* previous start was real too : p is one input period */
+        p = (unsigned int)(start - g_DetectPulseManager.fly_ref_tick);
+        period = g_DetectPulseManager.fly_period_ticks;
+
+        if (period == 0U)
+        {
+            if (p > g_DetectPulseManager.fixed_low_ticks)
+            {
+                g_DetectPulseManager.fly_period_q4 = p << 4;
+            }
+        }
+        else if ((p >= (period - (period >> 3))) && (p <= (period + (period >> 3))))
+        {
+            /* IIR 1/8 in 1/16 tick units, far off periods (missed edges) are ignored */
+            p_q4 = p << 4;
+            if (p_q4 >= g_DetectPulseManager.fly_period_q4)
+            {
+                g_DetectPulseManager.fly_period_q4 += (p_q4 - g_DetectPulseManager.fly_period_q4) >> 3;
+            }
+            else
+            {
+                g_DetectPulseManager.fly_period_q4 -= (g_DetectPulseManager.fly_period_q4 - p_q4) >> 3;
+            }
+        }
+
+        g_DetectPulseManager.fly_period_ticks = (g_DetectPulseManager.fly_period_q4 + 8U) >> 4;
+    }
+
+    g_DetectPulseManager.fly_ref_tick  = start;
+    g_DetectPulseManager.fly_ref_valid = 1U;
+    g_DetectPulseManager.fly_miss_cnt  = 0U;
+}
+#endif
+
+#if (DETECT_FILTER_TYPE != DETECT_FILTER_NONE)
+/* one raw P1.7 sample in, filtered level out (holds the last level when undecided) */
+static unsigned char detect_filter_sample(unsigned char raw)
+{
+    #if (DETECT_FILTER_TYPE == DETECT_FILTER_MAJORITY)
+    unsigned char win;
+    unsigned char ones;
+
+    g_DetectPulseManager.filt_shift = (unsigned char)((g_DetectPulseManager.filt_shift << 1) | raw);
+
+    win  = g_DetectPulseManager.filt_shift & DETECT_FILTER_M_MASK;
+    ones = detect_filter_popcnt4[win & 0x0FU] + detect_filter_popcnt4[win >> 4];
+
+    if (ones >= DETECT_FILTER_N)
+    {
+        g_DetectPulseManager.filt_state = 1U;
+    }
+    else if ((DETECT_FILTER_M - ones) >= DETECT_FILTER_N)
+    {
+        g_DetectPulseManager.filt_state = 0U;
+    }
+    #else
+    if (raw != 0U)
+    {
+        if (g_DetectPulseManager.filt_integ < DETECT_FILTER_INTEG_MAX)
+        {
+            g_DetectPulseManager.filt_integ++;
+        }
+        if (g_DetectPulseManager.filt_integ >= DETECT_FILTER_INTEG_MAX)
+        {
+            g_DetectPulseManager.filt_state = 1U;
+        }
+    }
+    else
+    {
+        if (g_DetectPulseManager.filt_integ != 0U)
+        {
+            g_DetectPulseManager.filt_integ--;
+        }
+        if (g_DetectPulseManager.filt_integ == 0U)
+        {
+            g_DetectPulseManager.filt_state = 0U;
+        }
+    }
+    #endif
+
+    if (raw != g_DetectPulseManager.filt_state)
+    {
+        DETECT_METRIC_INC(filt_glitch);
+    }
+
+    return g_DetectPulseManager.filt_state;
+}
+#endif
+
+#if defined (ENABLE_DETECT_SPAN)
+/* real window start : extend the period span, publish it once long enough */
+static void detect_span_edge(unsigned int start)
+{
+    unsigned int dt;
+
+    if (g_DetectPulseManager.span_active == 0U)
+    {
+        g_DetectPulseManager.span_start_tick = start;
+        g_DetectPulseManager.span_count      = 0U;
+        g_DetectPulseManager.span_active     = 1U;
+        return;
+    }
+
+    g_DetectPulseManager.span_count++;
+    dt = (unsigned int)(start - g_DetectPulseManager.span_start_tick);
+    if (dt >= DETECT_SPAN_GATE_TICKS)
+    {
+        g_DetectPulseManager.span_ticks   = dt;
+        g_DetectPulseManager.span_periods = g_DetectPulseManager.span_count;
+        g_DetectPulseManager.span_seq++;
+
+        /* next span starts on this edge, no gap */
+        g_DetectPulseManager.span_start_tick = start;
+        g_DetectPulseManager.span_count      = 0U;
+    }
+}
+#endif
+
+// Put under timer : 100us irq
+void output_pulse_irq(void)
+{
+    unsigned int dt;
+    unsigned int now;
+    unsigned char curr_input_state;
+
+    g_DetectPulseManager.tick100us++;
+
+    curr_input_state = (P17 == 1) ? 1U : 0U;
+    now  = g_DetectPulseManager.tick100us;
+
+    #if (DETECT_FILTER_TYPE != DETECT_FILTER_NONE)
+    DETECT_FILTER_PROFILE_BEGIN;
+    curr_input_state = detect_filter_sample(curr_input_state);
+    DETECT_FILTER_PROFILE_END;
+    #endif
+
+    /* 0) serve a pending calibration reset (main loop or drift) outside of an active window */
+    if (((g_DetectPulseManager.reset_ack_seq != g_DetectPulseManager.reset_req_seq) ||
+         (g_DetectPulseManager.recal_pending != 0U)) &&
+        (g_DetectPulseManager.state != DETECT_STATE_LOW_ACTIVE))
+    {
+        detect_calibration_clear();
+        g_DetectPulseManager.reset_ack_seq = g_DetectPulseManager.reset_req_seq;
+        g_DetectPulseManager.recal_pending = 0U;
+    }
+
+    #if defined (ENABLE_DETECT_SUPERVISOR)
+    /* 0b) loss of signal : no falling edge for DETECT_LOS_TIMEOUT_TICKS */
+    if (g_DetectPulseManager.los_countdown != 0U)
+    {
+        g_DetectPulseManager.los_countdown--;
+    }
+    else if (g_DetectPulseManager.los_active == 0U)
+    {
+        g_DetectPulseManager.los_active = 1U;
+        DETECT_METRIC_INC(los_events);
+        DETECT_TRACE(DETECT_EV_LOS);
+
+        /* drop the window in progress and the stale calibration, park P1.5 */
+        detect_calibration_clear();
+        g_OutputPulseManager.mode0   = 0U;
+        g_OutputPulseManager.mode100 = 0U;
+        P15 = (g_DetectPulseManager.failsafe_level != 0U) ? 1 : 0;
+    }
+    #endif
+
+    /* 1) handle LOW_PENDING -> LOW_ACTIVE confirmation */
+    if (g_DetectPulseManager.state == DETECT_STATE_LOW_PENDING)
+    {
+        #if defined (ENABLE_DETECT_FULL_WAVE)
+        if (g_DetectPulseManager.high_half_active != 0U)
+        {
+            /* edge not confirmed yet : the HIGH half pulse keeps running, a glitch the filter
+               rejects must not cut it short */
+            detect_duty_timing(now);
+        }
+        #endif
+
+        dt = (unsigned int)(now - g_DetectPulseManager.pending_start_tick);
+
+        #if (DETECT_FILTER_TYPE != DETECT_FILTER_NONE)
+        /* filtered level decides : LOW confirms (the edge tick is kept as window start),
+           still HIGH once the filter had time to settle -> burst of noise */
+        if (curr_input_state == 0U)
+        #else
+        if ((curr_input_state == 0U) && (dt >= LOW_CONFIRM_TICKS))
+        #endif
+        {
+            /* confirmed LOW window start */
+            #if defined (ENABLE_DETECT_FULL_WAVE)
+            if (g_DetectPulseManager.high_half_active != 0U)
+            {
+                /* confirmed falling edge ends the HIGH half window */
+                g_DetectPulseManager.high_half_active = 0U;
+                g_OutputPulseManager.mode0   = 0U;
+                g_OutputPulseManager.mode100 = 0U;
+                OUTPUT_PULSE_LOW;
+            }
+            detect_high_half_end(g_DetectPulseManager.pending_start_tick);
+            #endif
+            #if defined (ENABLE_DETECT_FLYWHEEL)
+            detect_flywheel_sync(g_DetectPulseManager.pending_start_tick);
+            #endif
+            #if defined (ENABLE_DETECT_SPAN)
+            detect_span_edge(g_DetectPulseManager.pending_start_tick);
+            #endif
+            FREQ_METER_EDGE_COMMIT(g_DetectPulseManager.pending_start_tick);
+            PWM0_SYNC_EDGE();
+            DETECT_TRACE(DETECT_EV_CONFIRM);
+            detect_window_begin(now, g_DetectPulseManager.pending_start_tick);
+        }
+        #if (DETECT_FILTER_TYPE != DETECT_FILTER_NONE)
+        else if ((curr_input_state != 0U) && (dt >= DETECT_FILTER_SETTLE_TICKS))
+        {
+            g_DetectPulseManager.state = DETECT_STATE_HIGH;
+            DETECT_METRIC_INC(filt_reject);
+            DETECT_METRIC_INC(noise_reject);
+            DETECT_TRACE(DETECT_EV_NOISE);
+        }
+        #else
+        else if (curr_input_state != 0U)
+        {
+            /* pulse returned HIGH before confirmation -> treat as noise */
+            g_DetectPulseManager.state = DETECT_STATE_HIGH;
+            DETECT_METRIC_INC(noise_reject);
+            DETECT_TRACE(DETECT_EV_NOISE);
+        }
+        #endif
+    }
+
+    #if defined (ENABLE_DETECT_FLYWHEEL)
+    /* 1b) flywheel : expected falling edge missing -> synthesize the window from the learned period */
+    if ((g_DetectPulseManager.state == DETECT_STATE_HIGH) &&
+        (g_DetectPulseManager.fly_ref_valid != 0U) &&
+        (g_DetectPulseManager.fly_period_ticks != 0U) &&
+        (g_DetectPulseManager.calib_done != 0U))
+    {
+        dt = (unsigned int)(now - g_DetectPulseManager.fly_ref_tick);
+        if (dt >= (g_DetectPulseManager.fly_period_ticks + DETECT_FLYWHEEL_MARGIN_TICKS))
+        {
+            DETECT_METRIC_INC(fly_missed);
+
+            if (g_DetectPulseManager.fly_miss_cnt < g_DetectPulseManager.fly_max_miss)
+            {
+                g_DetectPulseManager.fly_miss_cnt++;
+                g_DetectPulseManager.fly_ref_tick += g_DetectPulseManager.fly_period_ticks;
+                detect_window_begin(now, g_DetectPulseManager.fly_ref_tick);
+                g_DetectPulseManager.state = DETECT_STATE_FLYWHEEL;
+                DETECT_METRIC_INC(fly_synth);
+                DETECT_TRACE(DETECT_EV_SYNTH);
+                g_DetectPulseManager.span_active = 0U;  /* span counts real edges only */
+                FREQ_METER_RESTART();
+            }
+            else
+            {
+                /* too many misses in a row : stop coasting until a real edge resyncs */
+                g_DetectPulseManager.fly_ref_valid = 0U;
+            }
+        }
+    }
+    #endif
+
+    #if defined (ENABLE_DETECT_FULL_WAVE)
+    /* 1c) HIGH half window : own duty, timed on the calibrated HIGH width */
+    if (g_DetectPulseManager.state == DETECT_STATE_HIGH)
+    {
+        if (g_DetectPulseManager.high_half_req != 0U)
+        {
+            g_DetectPulseManager.high_half_req = 0U;
+
+            if ((g_DetectPulseManager.high_calib_done != 0U) &&
+                (g_DetectPulseManager.calib_done != 0U))
+            {
+                g_DetectPulseManager.high_half_active = 1U;
+                detect_output_begin(now, DETECT_HALF_HIGH);
+            }
+        }
+        else if (g_DetectPulseManager.high_half_active != 0U)
+        {
+            detect_duty_timing(now);
+        }
+    }
+    #endif
+
+    /* 2) handle LOW_ACTIVE window (duty + end-of-window) */
+    if (g_DetectPulseManager.state == DETECT_STATE_LOW_ACTIVE)
+    {
+        if (curr_input_state == 0U)
+        {
+            /* still LOW: handle duty timing */
+            detect_duty_timing(now);
+        }
+#if (DETECT_EDGE_MODE == DETECT_EDGE_MODE_INT1)
+        else
+        {
+            /* LOW window ended (rising edge), stamped back by the filter delay */
+            detect_window_end((unsigned int)(now - DETECT_FILTER_DELAY_TICKS));
+        }
+#endif
+    }
+    #if defined (ENABLE_DETECT_FLYWHEEL)
+    else if (g_DetectPulseManager.state == DETECT_STATE_FLYWHEEL)
+    {
+        /* synthesized window : ends after the calibrated LOW width, no statistics */
+        dt = (unsigned int)(now - g_DetectPulseManager.low_start_tick);
+        if (dt >= g_DetectPulseManager.fixed_low_ticks)
+        {
+            OUTPUT_PULSE_LOW;
+            g_OutputPulseManager.mode0   = 0U;
+            g_OutputPulseManager.mode100 = 0U;
+            g_DetectPulseManager.state   = DETECT_STATE_HIGH;
+        }
+        else
+        {
+            detect_duty_timing(now);
+        }
+    }
+    #endif
+
+    g_DetectPulseManager.prev_input_state = curr_input_state;
+}
+
+void input_pulse_irq(void)
+{
+    unsigned int now;
+
+    now = g_DetectPulseManager.tick100us;
+    DETECT_TRACE(DETECT_EV_FALL);
+
+    #if defined (ENABLE_DETECT_SUPERVISOR)
+    g_DetectPulseManager.los_countdown = DETECT_LOS_TIMEOUT_TICKS;
+    if (g_DetectPulseManager.los_active != 0U)
+    {
+        /* output follows the next confirmed window again */
+        g_DetectPulseManager.los_active = 0U;
+        DETECT_METRIC_INC(los_recover);
+    }
+    #endif
+
+    /* only start pending when not already inside a LOW window */
+    if ((g_DetectPulseManager.state == DETECT_STATE_HIGH) && (P17 == 0))
+    {
+        FREQ_METER_EDGE_STAMP();
+        g_DetectPulseManager.pending_start_tick = now;
+        g_DetectPulseManager.state = DETECT_STATE_LOW_PENDING;
+    }
+    #if defined (ENABLE_DETECT_FLYWHEEL)
+    else if ((g_DetectPulseManager.state == DETECT_STATE_FLYWHEEL) && (P17 == 0))
+    {
+        /* late real edge inside a synthesized window : take it over as a real window,
+           dt_low is measured from this edge, the flywheel restarts from here */
+        g_DetectPulseManager.low_start_tick = now;
+        g_DetectPulseManager.state          = DETECT_STATE_LOW_ACTIVE;
+        g_DetectPulseManager.fly_ref_tick   = now;
+        g_DetectPulseManager.fly_miss_cnt   = 0U;
+        DETECT_METRIC_INC(fly_resync);
+    }
+    #endif
+}
+
+#if (DETECT_EDGE_MODE == DETECT_EDGE_MODE_PIT)
+void input_rise_irq(void)
+{
+    unsigned int now;
+
+    now = g_DetectPulseManager.tick100us;
+    DETECT_TRACE(DETECT_EV_RISE);
+
+    if (g_DetectPulseManager.state == DETECT_STATE_LOW_ACTIVE)
+    {
+        /* both window edges are stamped in edge ISR -> no polling lag on dt_low */
+        detect_window_end(now);
+    }
+    else if (g_DetectPulseManager.state == DETECT_STATE_LOW_PENDING)
+    {
+        /* pulse returned HIGH before confirmation -> treat as noise */
+        g_DetectPulseManager.state = DETECT_STATE_HIGH;
+        DETECT_METRIC_INC(noise_reject);
+        DETECT_TRACE(DETECT_EV_NOISE);
+    }
+}
+
+void Pin_INT_ISR(void) interrupt 7       // Vector @  0x3B
+{
+    _push_(SFRS);
+
+    SFRS = 0;              //may preempt a page 1 window : TH2 / TL2 are page 0
+
+    if (P17 == 0)
+    {
+        input_pulse_irq();
+    }
+    else
+    {
+        input_rise_irq();
+    }
+
+    clr_PIF_PIF7;          //clr pin int flag wait next edge
+
+    _pop_(SFRS);
+}
+#else
+void INT1_ISR(void) interrupt 2          // Vector @  0x03
+{
+    _push_(SFRS);	
+
+    SFRS = 0;              //may preempt a page 1 window : TH2 / TL2 are page 0
+	
+    input_pulse_irq();
+
+    clr_TCON_IE1;          //clr int flag wait next falling edge
+
+    _pop_(SFRS);
+}
+#endif
+
+void EINT1_Init(void)
+{
+    /* INT1 pin P1.7 as Quasi mode with internal pull-high */
+    P17_QUASI_MODE;
+    P17 = 1;
+
+    #if (DETECT_EDGE_MODE == DETECT_EDGE_MODE_PIT)
+    /* pin interrupt channel 7 on port 1 (P1.7), both edge */
+    ENABLE_INT_PORT1;
+    ENABLE_BIT7_BOTHEDGE_TRIG;
+    clr_PIF_PIF7;
+    ENABLE_PIN_INTERRUPT;
+    SET_INT_PIT_LEVEL3;                 //same level as Timer1 : edge ISR and output_pulse_irq() never nest
+    #else
+    INT1_FALLING_EDGE_TRIG;             //setting trig condition level or edge
+    set_IE_EX1;                         //INT1_Enable;
+    SET_INT_INT1_LEVEL3;                //same level as Timer1 : tick100us is never read half updated
+    #endif
+    ENABLE_GLOBAL_INTERRUPT;            //Global interrupt enable
 
     // init P15 as GPIO output    
     P15_PUSHPULL_MODE;
     OUTPUT_PULSE_LOW;
 
+    #if defined (ENABLE_DETECT_FILTER_PROFILE)
+    P13_PUSHPULL_MODE;
+    DETECT_FILTER_PROFILE_END;
+    #endif
+
     g_DetectPulseManager.prev_input_state = (P17 == 0) ? 0U : 1U;
     g_DetectPulseManager.state            = DETECT_STATE_HIGH;
 }
 
+void Detect_SetFailsafeLevel(unsigned char level)
+{
+    g_DetectPulseManager.failsafe_level = (level != 0U) ? 1U : 0U;
+}
+
+void Detect_SetFlywheelMaxMiss(unsigned char max_miss)
+{
+    g_DetectPulseManager.fly_max_miss = max_miss;
+}
+
+unsigned int Duty_Scale(unsigned int duty, unsigned int period, unsigned long recip)
+{
+    unsigned int r;
+    unsigned long x2;
+
+    /* Q16 estimate, at most 1 off */
+    r = (unsigned int)(((unsigned long)duty * recip + 0x8000UL) >> 16);
+
+    /* exact round to nearest : (2r - 1) * D <= 2 * duty * period < (2r + 1) * D */
+    x2 = ((unsigned long)duty * (unsigned long)period) << 1;
+    if (x2 >= ((((unsigned long)r << 1) + 1UL) * DUTY_RESOLUTION_HI))
+    {
+        r++;
+    }
+    else if ((r != 0U) && (x2 < ((((unsigned long)r << 1) - 1UL) * DUTY_RESOLUTION_HI)))
+    {
+        r--;
+    }
+
+    return r;
+}
+
+void Detect_Process(void)
+{
+    unsigned char gen;
+    unsigned char curr;
+    unsigned char next;
+    unsigned char half;
+    unsigned char seq;
+    unsigned char moved;
+    unsigned int win[2];
+    unsigned long recip[2];
+    unsigned int d;
+    unsigned int on;
+    unsigned int step;
+    unsigned long step_l;
+
+    /* slew limiter : duty_ramp moves toward duty_target by slew_step per elapsed (half) window */
+    seq = g_OutputPulseManager.window_seq;
+    if ((g_OutputPulseManager.slew_step != 0U) && (seq != g_OutputPulseManager.slew_seq))
+    {
+        step_l = (unsigned long)g_OutputPulseManager.slew_step *
+                 (unsigned long)(unsigned char)(seq - g_OutputPulseManager.slew_seq);
+        step = (step_l > 0xFFFFUL) ? 0xFFFFU : (unsigned int)step_l;
+        g_OutputPulseManager.slew_seq = seq;
+
+        moved = 0U;
+        for (half = DETECT_HALF_LOW; half <= DETECT_HALF_HIGH; half++)
+        {
+            d = g_OutputPulseManager.duty_ramp[half];
+            if (d < g_OutputPulseManager.duty_target[half])
+            {
+                d = ((g_OutputPulseManager.duty_target[half] - d) > step) ?
+                    (d + step) : g_OutputPulseManager.duty_target[half];
+            }
+            else if (d > g_OutputPulseManager.duty_target[half])
+            {
+                d = ((d - g_OutputPulseManager.duty_target[half]) > step) ?
+                    (d - step) : g_OutputPulseManager.duty_target[half];
+            }
+
+            if (d != g_OutputPulseManager.duty_ramp[half])
+            {
+                g_OutputPulseManager.duty_ramp[half] = d;
+                moved = 1U;
+            }
+        }
+
+        if (moved != 0U)
+        {
+            detect_duty_publish(g_OutputPulseManager.duty_ramp[DETECT_HALF_LOW],
+                                g_OutputPulseManager.duty_ramp[DETECT_HALF_HIGH]);
+        }
+    }
+
+    gen = g_DetectPulseManager.calib_gen;
+    curr = g_OutputPulseManager.stage_idx;
+
+    if (g_DetectPulseManager.calib_done == 0U)
+    {
+        /* before calibration : the last measured LOW width (or the default), refilled each time
+           the ISR measures a new one ; HIGH half is not started before its own calibration */
+        do
+        {
+            win[DETECT_HALF_LOW] = g_DetectPulseManager.last_low_ticks;
+        } while (win[DETECT_HALF_LOW] != g_DetectPulseManager.last_low_ticks);
+        if (win[DETECT_HALF_LOW] == 0U)
+        {
+            win[DETECT_HALF_LOW] = DEFAULT_LOW_TICKS;
+        }
+        if ((g_OutputPulseManager.stage_gen[curr] == gen) &&
+            (g_OutputPulseManager.prov_win == win[DETECT_HALF_LOW]))
+        {
+            return;     /* published slot is up to date */
+        }
+        win[DETECT_HALF_HIGH] = 0U;
+
+        /* one division per measured width, only for the first few windows */
+        recip[DETECT_HALF_LOW]  = DUTY_RECIP_Q16(win[DETECT_HALF_LOW]);
+        recip[DETECT_HALF_HIGH] = 0UL;
+        g_OutputPulseManager.prov_win = win[DETECT_HALF_LOW];
+    }
+    else
+    {
+        if ((g_OutputPulseManager.stage_gen[curr] == gen) && (g_OutputPulseManager.prov_win == 0U))
+        {
+            return;     /* published slot is up to date */
+        }
+
+        /* 16-bit reads may be torn by the ISR : valid only if calib_gen did not move meanwhile */
+        win[DETECT_HALF_LOW]  = g_DetectPulseManager.fixed_low_ticks;
+        win[DETECT_HALF_HIGH] = (g_DetectPulseManager.high_calib_done != 0U) ?
+                                g_DetectPulseManager.fixed_high_ticks : 0U;
+        if ((win[DETECT_HALF_LOW] == 0U) || (gen != g_DetectPulseManager.calib_gen))
+        {
+            return;     /* changed meanwhile : next loop */
+        }
+
+        if (g_OutputPulseManager.recip_gen != gen)
+        {
+            /* one division per half and calibration, duty changes are multiply only */
+            g_OutputPulseManager.duty_recip[DETECT_HALF_LOW]  = DUTY_RECIP_Q16(win[DETECT_HALF_LOW]);
+            g_OutputPulseManager.duty_recip[DETECT_HALF_HIGH] = DUTY_RECIP_Q16(win[DETECT_HALF_HIGH]);
+            g_OutputPulseManager.recip_gen = gen;
+        }
+        recip[DETECT_HALF_LOW]  = g_OutputPulseManager.duty_recip[DETECT_HALF_LOW];
+        recip[DETECT_HALF_HIGH] = g_OutputPulseManager.duty_recip[DETECT_HALF_HIGH];
+        g_OutputPulseManager.prov_win = 0U;
+    }
+
+    next = curr ^ 1U;
+    for (half = DETECT_HALF_LOW; half <= DETECT_HALF_HIGH; half++)
+    {
+        d = g_OutputPulseManager.duty_stage[curr][half];
+        g_OutputPulseManager.duty_stage[next][half] = d;
+
+        on = Duty_Scale(d, win[half], recip[half]);
+        if (on == 0U)
+        {
+            on = 1U;    /* avoid 0 tick HIGH */
+        }
+        g_OutputPulseManager.on_stage[next][half] = on;
+    }
+
+    g_OutputPulseManager.stage_gen[next] = gen;
+    g_OutputPulseManager.stage_idx = next;
+}
+
+void Detect_AutoRange_process(void)
+{
+    #if defined (ENABLE_DETECT_AUTO_RANGE)
+    unsigned char i;
+    unsigned char best;
+    unsigned int cnt;
+    unsigned long weighted;
+    unsigned int center;
+    unsigned int margin;
+
+    /* ISR does not touch the histogram nor the window outside of LEARNING / LOCKED */
+    if (g_DetectPulseManager.range_state == AUTO_RANGE_RESTART)
+    {
+        for (i = 0U; i < AUTO_RANGE_BINS; i++)
+        {
+            auto_range_hist[i] = 0U;
+        }
+        g_DetectPulseManager.learn_cnt   = 0U;
+        g_DetectPulseManager.range_state = AUTO_RANGE_LEARNING;
+        return;
+    }
+
+    if (g_DetectPulseManager.range_state != AUTO_RANGE_READY)
+    {
+        return;
+    }
+
+    best = 0U;
+    for (i = 1U; i < AUTO_RANGE_BINS; i++)
+    {
+        if (auto_range_hist[i] > auto_range_hist[best])
+        {
+            best = i;
+        }
+    }
+
+    /* refine the mode with its neighbour bins (bin centre = i*4+2 ticks) */
+    cnt      = 0U;
+    weighted = 0UL;
+    for (i = ((best > 0U) ? (best - 1U) : 0U); (i <= (best + 1U)) && (i < AUTO_RANGE_BINS); i++)
+    {
+        cnt      += auto_range_hist[i];
+        weighted += (unsigned long)auto_range_hist[i] *
+                    (unsigned long)(((unsigned int)i << AUTO_RANGE_BIN_SHIFT) + (1U << (AUTO_RANGE_BIN_SHIFT - 1U)));
+    }
+
+    if (cnt < AUTO_RANGE_MIN_DOMINANT)
+    {
+        /* no dominant LOW width : learn again */
+        g_DetectPulseManager.range_state = AUTO_RANGE_RESTART;
+        return;
+    }
+
+    center = (unsigned int)(weighted / (unsigned long)cnt);
+    margin = center >> AUTO_RANGE_MARGIN_SHIFT;
+
+    g_DetectPulseManager.period_min_ticks =
+        ((center - margin) > MIN_LOW_TICKS) ? (center - margin) : MIN_LOW_TICKS;
+    g_DetectPulseManager.period_max_ticks = center + margin;
+
+    /* restart calibration inside the new window, then publish it to ISR */
+    Reset_EINT_calibration();
+    g_DetectPulseManager.range_state = AUTO_RANGE_LOCKED;
+    #endif
+}
+
+void Detect_AutoRange_Restart(void)
+{
+    #if defined (ENABLE_DETECT_AUTO_RANGE)
+    if (g_DetectPulseManager.range_state == AUTO_RANGE_LOCKED)
+    {
+        g_DetectPulseManager.range_state = AUTO_RANGE_RESTART;
+    }
+    #endif
+}
+
+/* copy of the metrics counters, seqlock retry against the ISRs, main loop only */
+void Detect_Metrics_Snapshot(DETECT_METRICS_T *p_metrics)
+{
+    unsigned char seq;
+
+    /* whole block in one burst, retried if a counter moved meanwhile */
+    do
+    {
+        seq = g_DetectMetrics.seq;
+        *p_metrics = g_DetectMetrics;
+    } while (((seq & 1U) != 0U) || (seq != g_DetectMetrics.seq));
+}
+
+void Detect_Metrics_Dump(void)
+{
+    DETECT_METRICS_T m;
+
+    Detect_Metrics_Snapshot(&m);
+
+    printf("Metrics: windows=%u calib=%u noise=%u short=%u range=%u\r\n",
+           m.windows,
+           m.calibrations,
+           m.noise_reject,
+           m.too_short,
+           m.out_of_range);
+    printf("Metrics: los=%u recover=%u recal=%u fly miss=%u synth=%u resync=%u filt=%u glitch=%u\r\n",
+           m.los_events,
+           m.los_recover,
+           m.drift_recal,
+           m.fly_missed,
+           m.fly_synth,
+           m.fly_resync,
+           m.filt_reject,
+           m.filt_glitch);
+}
+
+void Detect_Stats_Snapshot(DETECT_STATS_T *p_stats)
+{
+    unsigned char seq;
+
+    /* retry until the ISR did not touch the block during the copy */
+    do
+    {
+        seq = g_DetectStats.seq;
+        p_stats->n            = g_DetectStats.n;
+        p_stats->min          = g_DetectStats.min;
+        p_stats->max          = g_DetectStats.max;
+        p_stats->sum          = g_DetectStats.sum;
+        p_stats->sumsq        = g_DetectStats.sumsq;
+    } while (((seq & 1U) != 0U) || (seq != g_DetectStats.seq));
+
+    p_stats->seq       = seq;
+    p_stats->clear_req = g_DetectStats.clear_req;
+}
+
+void Detect_Stats_Clear(void)
+{
+    g_DetectStats.clear_req = 1U;
+}
+
+void Detect_Stats_Dump(void)
+{
+#if defined (ENABLE_DETECT_STATS)
+    DETECT_STATS_T st;
+    unsigned char i;
+    unsigned char seq;
+    unsigned int cnt;
+    unsigned int mean_x10;
+    unsigned long mean_sq;
+    unsigned long var;
+
+    Detect_Stats_Snapshot(&st);
+
+    printf("Stats: n=%u min=%u max=%u\r\n",
+           st.n,
+           (st.n != 0U) ? st.min : 0U,
+           st.max);
+
+    if (st.n != 0U)
+    {
+        /* var = E[x^2] - E[x]^2, integer ticks^2 (display only) */
+        mean_x10 = (unsigned int)((st.sum * 10UL) / st.n);
+        mean_sq  = ((unsigned long)mean_x10 * mean_x10) / 100UL;
+        var      = st.sumsq / st.n;
+        var      = (var > mean_sq) ? (var - mean_sq) : 0UL;
+        printf("Stats: mean=%u.%u ticks var=%lu ticks^2\r\n",
+               mean_x10 / 10U,
+               mean_x10 % 10U,
+               var);
+    }
+
+    for (i = 0U; i < DETECT_STATS_BINS; i++)
+    {
+        do
+        {
+            seq = g_DetectStats.seq;
+            cnt = detect_stats_hist[i];
+        } while (((seq & 1U) != 0U) || (seq != g_DetectStats.seq));
+
+        if (cnt != 0U)
+        {
+            printf("  %3u..%3u : %u\r\n",
+                   (unsigned int)i << DETECT_STATS_BIN_SHIFT,
+                   (i == (DETECT_STATS_BINS - 1U)) ? 0xFFFFU :
+                   ((((unsigned int)i + 1U) << DETECT_STATS_BIN_SHIFT) - 1U),
+                   cnt);
+        }
+    }
+#else
+    printf("Stats: disabled\r\n");
+#endif
+}
+
+void Detect_Trace_Arm(unsigned char trigger)
+{
+    /* writers skip while frozen : safe to reset from the main loop */
+    g_DetectTrace.frozen   = 1U;
+    g_DetectTrace.trigger  = trigger;
+    g_DetectTrace.post_cnt = 0U;
+    g_DetectTrace.armed    = 1U;
+    g_DetectTrace.frozen   = 0U;
+}
+
+void Detect_Trace_Dump(void)
+{
+#if defined (ENABLE_DETECT_TRACE)
+    static char code *code detect_trace_name[DETECT_EV_COUNT] =
+    {
+        "fall", "rise", "confirm", "noise", "out_H", "out_L", "calib", "recal", "los", "synth"
+    };
+    unsigned char was_frozen;
+    unsigned char idx;
+    unsigned char n;
+    unsigned char ev;
+
+    /* an ISR in progress completes before the main loop resumes : buffer is stable from here */
+    was_frozen = g_DetectTrace.frozen;
+    g_DetectTrace.frozen = 1U;
+
+    printf("Trace: %u events%s (tick100us.sub, sub in 0.5us)\r\n",
+           (unsigned int)g_DetectTrace.count,
+           (was_frozen != 0U) ? ", frozen by trigger" : "");
+
+    idx = (g_DetectTrace.head - g_DetectTrace.count) & (DETECT_TRACE_SIZE - 1U);
+    for (n = 0U; n < g_DetectTrace.count; n++)
+    {
+        ev = detect_trace_buf[idx].ev;
+        printf("  %5u.%3u %s\r\n",
+               detect_trace_buf[idx].tick,
+               (unsigned int)detect_trace_buf[idx].sub,
+               (ev < DETECT_EV_COUNT) ? detect_trace_name[ev] : "?");
+        idx = (idx + 1U) & (DETECT_TRACE_SIZE - 1U);
+    }
+
+    g_DetectTrace.frozen = was_frozen;
+#else
+    printf("Trace: disabled\r\n");
+#endif
+}
+
 /* debug helper:
  * print LOW window ticks and an approximate frequency
  * (assuming LOW window = half period and tick≈100us)
@@ -318,9 +1801,25 @@ void Detect_GetFreq_log(void)
 
     Tlow = g_DetectPulseManager.fixed_low_ticks;
     
-    if (Tlow == 0U)
+    if (g_DetectPulseManager.los_active != 0U)
+    {
+        printf("Detect: signal lost, P15=%u (los %u, recover %u, drift recal %u)\r\n",
+               (unsigned int)g_DetectPulseManager.failsafe_level,
+               g_DetectMetrics.los_events,
+               g_DetectMetrics.los_recover,
+               g_DetectMetrics.drift_recal);
+    }
+    else if (g_DetectPulseManager.range_state != AUTO_RANGE_LOCKED)
     {
-        printf("Detect: not ready yet\r\n");
+        printf("Detect: learning input range (%u/%u)\r\n",
+               (unsigned int)g_DetectPulseManager.learn_cnt,
+               (unsigned int)AUTO_RANGE_LEARN_SAMPLES);
+    }
+    else if (Tlow == 0U)
+    {
+        printf("Detect: not ready yet (window %u~%u ticks)\r\n",
+               g_DetectPulseManager.period_min_ticks,
+               g_DetectPulseManager.period_max_ticks);
     }
     else
     {
@@ -331,6 +1830,32 @@ void Detect_GetFreq_log(void)
         printf("Detect: Tlow=%u ticks, approx freq=%u Hz (assume 50%% duty, 100us tick)\r\n",
                Tlow,
                approx_freq);    
+
+        #if defined (ENABLE_DETECT_FULL_WAVE)
+        if (g_DetectPulseManager.high_calib_done != 0U)
+        {
+            printf("Detect: Thigh=%u ticks, period=%u ticks\r\n",
+                   g_DetectPulseManager.fixed_high_ticks,
+                   Tlow + g_DetectPulseManager.fixed_high_ticks);
+        }
+        #endif
+
+        #if defined (ENABLE_DETECT_FLYWHEEL)
+        if (g_DetectMetrics.fly_missed != 0U)
+        {
+            printf("Detect: flywheel period=%u ticks, missed=%u, synth=%u, resync=%u\r\n",
+                   g_DetectPulseManager.fly_period_ticks,
+                   g_DetectMetrics.fly_missed,
+                   g_DetectMetrics.fly_synth,
+                   g_DetectMetrics.fly_resync);
+        }
+        #endif
+
+        #if (DETECT_FILTER_TYPE != DETECT_FILTER_NONE)
+        printf("Detect: filter reject=%u, glitch samples=%u\r\n",
+               g_DetectMetrics.filt_reject,
+               g_DetectMetrics.filt_glitch);
+        #endif
     }
 
 }
@@ -32,14 +32,46 @@
 typedef enum {
     DETECT_STATE_HIGH = 0,             /* waiting for next LOW window */
     DETECT_STATE_LOW_PENDING,          /* saw falling edge, waiting for confirmation */
-    DETECT_STATE_LOW_ACTIVE            /* confirmed LOW window in progress */
+    DETECT_STATE_LOW_ACTIVE,           /* confirmed LOW window in progress */
+    DETECT_STATE_FLYWHEEL              /* synthesized LOW window (falling edge missed) */
 } DETECT_STATE_T;
 
+typedef enum {
+    AUTO_RANGE_LEARNING = 0,           /* ISR fills the LOW width histogram */
+    AUTO_RANGE_READY,                  /* histogram full, main loop picks the dominant mode */
+    AUTO_RANGE_RESTART,                /* main loop clears the histogram and learns again */
+    AUTO_RANGE_LOCKED                  /* period_min_ticks / period_max_ticks valid */
+} AUTO_RANGE_STATE_T;
+
+typedef struct _detect_burst_t
+{
+    unsigned char count;            /* pulses per window, 0 = none */
+    unsigned int width;             /* HIGH ticks of each pulse */
+    unsigned int gap;               /* LOW ticks between pulses */
+}DETECT_BURST_T;
+
 typedef struct _output_pulse_manager_t
 {
-    unsigned int duty_resolution;   /* e.g. 100 => 0..100 % */
-    unsigned int duty_percent;      /* current target duty (0..resolution) */
-    unsigned int duty_latched;      /* duty value latched at window start */
+    unsigned int duty_resolution;   /* DUTY_RESOLUTION_HI => 0..10000 = 0.00..100.00 % */
+    unsigned int duty_percent;      /* current target duty (0..resolution), main loop copy */
+    unsigned int duty_stage[2][2];  /* [slot][half] double buffer : main loop fills the slot ISR is not reading */
+    unsigned char stage_idx;        /* slot published to ISR (0/1), flipped after the write */
+    unsigned int duty_target[2];    /* [half] duty asked by PWM_Set*DutyPercent(), main loop only */
+    unsigned int duty_ramp[2];      /* [half] duty published so far, steps toward duty_target */
+    unsigned int slew_step;         /* max duty change per (half) window, 0 = no limiter */
+    unsigned char window_seq;       /* bumped by ISR at each (half) window start */
+    unsigned char slew_seq;         /* window_seq already consumed by the slew limiter */
+    unsigned char half_enable[2];   /* [half] 0: no output pulse in that half window */
+    unsigned int on_stage[2][2];    /* [slot][half] P1.5 HIGH ticks precomputed by Detect_Process() */
+    unsigned char stage_gen[2];     /* [slot] calib_gen on_stage was computed for, 0 = not computed */
+    unsigned long duty_recip[2];    /* [half] DUTY_RECIP_Q16(calibrated width), main loop only */
+    unsigned char recip_gen;        /* calib_gen duty_recip was computed for */
+    unsigned int prov_win;          /* LOW width on_stage was filled from before calibration, 0 = calibrated fill */
+    unsigned char output_mode;      /* DETECT_OUTPUT_LEADING / _TRAILING / _BURST, main loop writes */
+    unsigned char mode_latched;     /* output_mode latched at (half) window start */
+    DETECT_BURST_T burst_stage[2];  /* burst schedule double buffer, same scheme as duty_stage */
+    unsigned char burst_idx;        /* burst slot published to ISR (0/1) */
+    unsigned int duty_latched;      /* duty value latched at (half) window start */
     unsigned char mode0;            /* 1: force 0% for whole window */
     unsigned char mode100;          /* 1: force 100% for whole window */
 	
@@ -56,6 +88,13 @@ typedef struct _detect_pulse_manager_t
     unsigned int pending_start_tick;/* tick value when LOW_PENDING started */
 
     unsigned int high_ticks;        /* HIGH duration (in ticks) for 1..99% duty */
+    unsigned int on_hold[2];        /* [half] last on_stage taken, reused while the slot is being refilled */
+    unsigned int delay_ticks;       /* trailing edge : P1.5 rises this many ticks after window start */
+    unsigned int burst_phase;       /* burst : ticks left in the current pulse / gap */
+    unsigned int burst_width;       /* burst : latched pulse width */
+    unsigned int burst_gap;         /* burst : latched gap */
+    unsigned char burst_left;       /* burst : pulses left, including the current one */
+    unsigned char burst_level;      /* burst : 1 in a pulse, 0 in a gap */
     unsigned int last_low_ticks;    /* last valid LOW width */
     unsigned int fixed_low_ticks;   /* averaged LOW width after calibration */
 
@@ -65,34 +104,363 @@ typedef struct _detect_pulse_manager_t
     unsigned char calib_done;       /* 1: fixed_low_ticks valid */
 
     unsigned char prev_input_state; /* last sampled detect pulse value (0/1) */
+
+    unsigned char reset_req_seq;    /* bumped by main loop to request a calibration reset */
+    unsigned char reset_ack_seq;    /* last reset request served by ISR */
+
+    unsigned int period_min_ticks;  /* LOW width acceptance window for calibration */
+    unsigned int period_max_ticks;
+    AUTO_RANGE_STATE_T range_state; /* calibration only runs when LOCKED */
+    unsigned char learn_cnt;        /* LOW windows put into the histogram */
+
+    unsigned char recal_pending;    /* 1: ISR requested a calibration reset (drift) */
+    unsigned int los_countdown;     /* ticks left before loss of signal, reloaded on falling edge */
+    unsigned char los_active;       /* 1: signal lost, P1.5 held at failsafe_level */
+    unsigned char failsafe_level;   /* P1.5 level while signal lost (0/1) */
+    unsigned char drift_cnt;        /* consecutive drifted LOW windows */
+
+    unsigned int fly_period_q4;     /* learned fall-to-fall period, 1/16 tick units */
+    unsigned int fly_period_ticks;  /* rounded fly_period_q4 */
+    unsigned int fly_ref_tick;      /* last window start, real or synthesized */
+    unsigned char fly_ref_valid;    /* 1: fly_ref_tick usable */
+    unsigned char fly_miss_cnt;     /* consecutive synthesized windows */
+    unsigned char fly_max_miss;     /* max consecutive synthesized windows, 0 = flywheel off */
+
+    unsigned char filt_shift;       /* last 8 raw P1.7 samples, bit0 = newest */
+    unsigned char filt_integ;       /* integrator 0..DETECT_FILTER_INTEG_MAX */
+    unsigned char filt_state;       /* filtered P1.7 level (0/1) */
+
+    unsigned int high_start_tick;   /* rising edge, start of the HIGH half window */
+    unsigned char high_start_valid; /* 1: high_start_tick taken from a real window end */
+    unsigned char high_half_req;    /* 1: window end seen, HIGH half output to start on next tick */
+    unsigned char high_half_active; /* 1: output pulse of the HIGH half in progress */
+    unsigned long sum_high;         /* accumulate HIGH widths for calibration */
+    unsigned int min_high;          /* min for min/max rejection */
+    unsigned int max_high;          /* max for min/max rejection */
+    unsigned char high_sample_cnt;  /* number of HIGH windows collected */
+    unsigned char high_calib_done;  /* 1: fixed_high_ticks valid */
+    unsigned int last_high_ticks;   /* last valid HIGH width */
+    unsigned int fixed_high_ticks;  /* averaged HIGH width after calibration */
+
+    unsigned char calib_gen;        /* bumped by ISR on every fixed_low_ticks / fixed_high_ticks change, never 0 */
+
+    unsigned int span_start_tick;   /* first real window start of the running span */
+    unsigned int span_count;        /* real periods in the running span */
+    unsigned char span_active;      /* 0: next real window start opens a new span */
+    unsigned int span_ticks;        /* published : ticks over span_periods real periods */
+    unsigned int span_periods;      /* published : periods in span_ticks */
+    unsigned char span_seq;         /* bumped after span_ticks / span_periods are written */
 }DETECT_PULSE_MANAGER_T;
 
+extern volatile DETECT_PULSE_MANAGER_T g_DetectPulseManager;
+
+/* health counters, one contiguous block : Detect_Metrics_Snapshot() copies it in one burst
+   for UART / I2C ; every counter saturates at 0xFFFF */
+typedef struct _detect_metrics_t
+{
+    unsigned char seq;              /* odd while the ISR bumps a counter */
+    unsigned int windows;           /* LOW windows ended (all widths) */
+    unsigned int calibrations;      /* fixed_low_ticks / fixed_high_ticks (re)computed */
+    unsigned int noise_reject;      /* falling edges not confirmed (pending -> HIGH) */
+    unsigned int too_short;         /* LOW windows under MIN_LOW_TICKS */
+    unsigned int out_of_range;      /* LOW windows outside period_min_ticks..period_max_ticks (locked range) */
+    unsigned int los_events;        /* input stopped toggling (timeout) */
+    unsigned int los_recover;       /* input came back after a loss */
+    unsigned int drift_recal;       /* automatic recalibrations on drift / frequency jump */
+    unsigned int fly_missed;        /* expected falling edges not seen */
+    unsigned int fly_synth;         /* windows synthesized by the flywheel */
+    unsigned int fly_resync;        /* late real edges taken over inside a synthesized window */
+    unsigned int filt_reject;       /* falling edges dropped by the filter as noise */
+    unsigned int filt_glitch;       /* raw samples disagreeing with the filtered level */
+}DETECT_METRICS_T;
+
+extern volatile DETECT_METRICS_T g_DetectMetrics;
+
+typedef struct _detect_stats_t
+{
+    unsigned char seq;              /* odd while the ISR updates the block, main loop copies on even + unchanged */
+    unsigned char clear_req;        /* 1: main loop asks the ISR to clear the block */
+    unsigned int n;                 /* LOW windows in the moments below (halved at DETECT_STATS_DECAY_N) */
+    unsigned int min;               /* shortest LOW width since clear */
+    unsigned int max;               /* longest LOW width since clear */
+    unsigned long sum;              /* sum of widths, for the mean */
+    unsigned long sumsq;            /* sum of squared widths, for the variance */
+}DETECT_STATS_T;
+
+extern volatile DETECT_STATS_T g_DetectStats;
+
+typedef enum {
+    DETECT_EV_FALL = 0,                /* falling edge on P1.7 (edge ISR) */
+    DETECT_EV_RISE,                    /* rising edge on P1.7 (PIT mode edge ISR) */
+    DETECT_EV_CONFIRM,                 /* LOW window confirmed */
+    DETECT_EV_NOISE,                   /* falling edge rejected as noise */
+    DETECT_EV_OUT_RISE,                /* P1.5 LOW -> HIGH */
+    DETECT_EV_OUT_FALL,                /* P1.5 HIGH -> LOW */
+    DETECT_EV_CALIB_DONE,              /* fixed_low_ticks / fixed_high_ticks updated */
+    DETECT_EV_RECAL,                   /* drift : recalibration requested */
+    DETECT_EV_LOS,                     /* loss of signal */
+    DETECT_EV_SYNTH,                   /* flywheel synthesized a window */
+    DETECT_EV_COUNT
+} DETECT_EVENT_T;
+
+typedef struct _detect_trace_entry_t
+{
+    unsigned int tick;              /* tick100us at the event */
+    unsigned char sub;              /* TIMEBASE_SUBTICK() at the event : 0.5us steps inside the tick, 0..199 */
+    unsigned char ev;               /* DETECT_EVENT_T */
+}DETECT_TRACE_ENTRY_T;
+
+typedef struct _detect_trace_t
+{
+    unsigned char head;             /* next entry to write */
+    unsigned char count;            /* valid entries, up to DETECT_TRACE_SIZE */
+    unsigned char frozen;           /* 1: writers skip, buffer kept for the dump */
+    unsigned char armed;            /* 1: trigger event starts the post-trigger countdown */
+    unsigned char trigger;          /* DETECT_EVENT_T that freezes the recorder */
+    unsigned char post_cnt;         /* events still recorded after the trigger, 0 = not triggered */
+}DETECT_TRACE_T;
+
+extern volatile DETECT_TRACE_T g_DetectTrace;
+
 #define DETECT_PULSE_SAMPLES   		(10U)  /* number of LOW windows for calibration */
 #define LOW_CONFIRM_TICKS         	(1U) 
 #define MIN_LOW_TICKS       		(5U)   /* 5 * 100us = 500us , if lower than 500us , regard as noise */
+#define DEFAULT_LOW_TICKS       	(50U)  /* LOW window assumed before the first width is measured (5.0 ms) */
+
+/* edge source of the detect pin P1.7
+   INT1 : INT1 falling edge starts the window, window end polled by the 100us tick (up to 1 tick late)
+   PIT  : pin interrupt on both edges, window end and P1.5 LOW done in the rising edge ISR */
+#define DETECT_EDGE_MODE_INT1      	(0)
+#define DETECT_EDGE_MODE_PIT       	(1)
+#define DETECT_EDGE_MODE           	(DETECT_EDGE_MODE_INT1)
 
 /* expect 100Hz / 120Hz，LOW window 4~6 ms (40~60 ticks) */
 #define PERIOD_MIN_TICKS       		(40U)  /* 4.0 ms  =  40 ticks */
 #define PERIOD_MAX_TICKS       		(80U)  /* 8.0 ms  =  80 ticks */
+
+/* learn the acceptance window at startup instead of PERIOD_MIN_TICKS / PERIOD_MAX_TICKS :
+   histogram of LOW widths -> dominant mode -> window = mode +/- mode/4
+   (50/60Hz mains, 100/120Hz rectified mains ... without rebuild) */
+#define ENABLE_DETECT_AUTO_RANGE
+
+#define AUTO_RANGE_LEARN_SAMPLES    (32U)  /* LOW windows collected before picking the mode */
+#define AUTO_RANGE_BIN_SHIFT        (2U)   /* bin width 4 ticks = 400us */
+#define AUTO_RANGE_BINS             (64U)  /* 64 bins : LOW width up to 25.5 ms (~20Hz at 50% duty) */
+#define AUTO_RANGE_MARGIN_SHIFT     (2U)   /* window = mode +/- (mode >> 2) */
+#define AUTO_RANGE_MIN_DOMINANT     (AUTO_RANGE_LEARN_SAMPLES / 4U) /* else no clear mode, learn again */
+
+/* input supervision : loss of signal -> failsafe P1.5 level, drift -> automatic recalibration */
+#define ENABLE_DETECT_SUPERVISOR
+
+#define DETECT_LOS_TIMEOUT_TICKS    (500U) /* 50 ms without falling edge = signal lost (> 2 periods at 50Hz) */
+#define DETECT_FAILSAFE_LEVEL       (0U)   /* default P1.5 level while signal lost */
+#define DETECT_DRIFT_SHIFT          (3U)   /* |dt_low - fixed_low_ticks| > fixed_low_ticks/8 = drifted */
+#define DETECT_DRIFT_CONFIRM        (3U)   /* consecutive drifted windows before recalibration */
+
+/* persistent LOW width statistics : histogram (XDATA), min / max / mean / variance, reject counts ;
+   dumped over UART ('s') while the engine keeps running */
+#define ENABLE_DETECT_STATS
+
+#define DETECT_STATS_BINS           (32U)  /* last bin also takes everything longer */
+#define DETECT_STATS_BIN_SHIFT      (2U)   /* bin width 4 ticks = 400us */
+#define DETECT_STATS_DECAY_N        (1024U)/* n, sum, sumsq halved here : recent windows weigh more, no overflow */
+#define DETECT_STATS_MAX_TICKS      (2047U)/* wider windows only go to the histogram (sumsq < 2^32) */
+
+/* edge event flight recorder : ring of timestamped events in XDATA, frozen some events after a trigger ;
+   UART 't' dumps it, 'T' re-arms the trigger */
+#define ENABLE_DETECT_TRACE
+
+#define DETECT_TRACE_SIZE           (64U)  /* power of 2, 4 bytes each */
+#define DETECT_TRACE_POST           (16U)  /* events kept after the trigger */
+#define DETECT_TRACE_TRIGGER_DEFAULT (DETECT_EV_LOS)
+
+/* period span : tick count over consecutive real periods (fall to fall), published once the span
+   passes DETECT_SPAN_GATE_TICKS ; mains referenced clock check (hirc_trim.c) */
+#define ENABLE_DETECT_SPAN
+
+#define DETECT_SPAN_GATE_TICKS      (10000U)   /* ~1 s : 1 tick edge jitter = 0.01 % */
+
+/* flywheel : once calibrated, synthesize a missing window from the learned period */
+#define ENABLE_DETECT_FLYWHEEL
+
+#define DETECT_FLYWHEEL_MAX_MISS    (3U)   /* default max consecutive synthesized windows */
+#define DETECT_FLYWHEEL_MARGIN_TICKS (LOW_CONFIRM_TICKS + 1U) /* wait past the expected edge */
+
+/* full wave : second output pulse in the HIGH half window (rising edge -> next falling edge),
+   own HIGH width calibration, each half enabled and duty controlled on its own
+   opt-in : doubles the output pulses, PWM_SetHalfEnable() turns either half off at run time */
+// #define ENABLE_DETECT_FULL_WAVE
+
+#define DETECT_HALF_LOW             (0U)
+#define DETECT_HALF_HIGH            (1U)
+#define DETECT_HIGH_MAX_TICKS       (300U) /* 30 ms, longer HIGH widths are not calibrated */
+
+/* output edge inside a (half) window
+   LEADING  : P1.5 HIGH at window start, LOW after the duty part
+   TRAILING : P1.5 LOW at window start, HIGH after a phase delay, until window end
+   BURST    : count pulses of width ticks separated by gap ticks from window start,
+              cut at window end ; duty 0 or disabled half = no burst */
+#define DETECT_OUTPUT_LEADING       (0U)
+#define DETECT_OUTPUT_TRAILING      (1U)
+#define DETECT_OUTPUT_BURST         (2U)
+#define DETECT_OUTPUT_MODE_DEFAULT  (DETECT_OUTPUT_LEADING)
+
+/* high resolution duty : 0..10000 = 0.01 % steps
+   ticks = round(duty * period / 10000) via a Q16 reciprocal precomputed once per period,
+   Duty_Scale() then needs multiplies only and matches UDIV_ROUND_NEAREST exactly */
+#define DUTY_RESOLUTION_HI          (10000U)
+#define DUTY_RECIP_Q16(period)      ((((unsigned long)(period)) << 16) / (unsigned long)DUTY_RESOLUTION_HI)
+
+/* command -> output duty curve, applied in the main loop when a duty is published
+   (ISR cost unchanged), tables in duty_curve.h generated by tools/gen_duty_curve.py
+   (run by hand, the build uses the committed header)
+   LINEAR     : output = command
+   GAMMA      : perceptual dimming, output = command ^ gamma
+   SINE_POWER : phase giving a linear share of the sine half wave power (resistive load) */
+#define DUTY_CURVE_LINEAR           (0)
+#define DUTY_CURVE_GAMMA            (1)
+#define DUTY_CURVE_SINE_POWER       (2)
+#define DETECT_DUTY_CURVE           (DUTY_CURVE_LINEAR)
+
+/* duty slew limiter : duty moves by at most this step (duty_resolution units) per (half) window,
+   0 = new duty applied in full at the next window ; PWM_SetSlewStep() at runtime */
+#define DETECT_SLEW_STEP_DEFAULT    (0U)
+
+/* sampled filter on P1.7 ahead of the state machine (one sample per 100us tick)
+   NONE       : raw pin, LOW_CONFIRM_TICKS check only
+   MAJORITY   : last M samples in a shift register, output flips when N of M agree (N > M/2)
+   INTEGRATOR : up/down counter 0..DETECT_FILTER_INTEG_MAX, output flips at the rails
+   both filters delay the window edges, the window end timestamp is compensated by
+   DETECT_FILTER_DELAY_TICKS, P1.5 LOW at window end is still late by that amount
+
+   rejection, worked out from the sampling (100us samples, a pulse of width w lands on
+   floor(w/100us)..ceil(w/100us) samples), not a bench capture :
+   NONE       : LOW_CONFIRM_TICKS = 1, a LOW shorter than one tick is missed or confirmed by chance
+   MAJORITY   : M = 5, N = 4 : LOW glitch <= 300us always rejected, >= 400us always passes ;
+                the window slides, isolated glitches never add up
+   INTEGRATOR : MAX = 4 : same 300us / 400us bounds for an isolated glitch, glitches closer than
+                their own width add up (net count), better on bursts, worse on dense chatter
+
+   cost per 100us tick in output_pulse_irq() (large model, 1T core, MOVX ~4 SYSCLK) :
+   UNMEASURED, counted from the instruction sequence only ; scope P1.3 with
+   ENABLE_DETECT_FILTER_PROFILE on the target and replace these with the measured widths
+   NONE       : 0
+   MAJORITY   : ~75 SYSCLK (~3.1 us @ 24 MHz), 3 % of the tick
+   INTEGRATOR : ~55 SYSCLK (~2.3 us @ 24 MHz), 2 % of the tick
+   +~40 SYSCLK on a tick that counts filt_glitch (metrics seqlock) */
+#define DETECT_FILTER_NONE          (0)
+#define DETECT_FILTER_MAJORITY      (1)
+#define DETECT_FILTER_INTEGRATOR    (2)
+#define DETECT_FILTER_TYPE          (DETECT_FILTER_NONE)
+
+#define DETECT_FILTER_M             (5U)   /* majority window, 1..8 samples */
+#define DETECT_FILTER_N             (4U)   /* samples that must agree to flip the output */
+#define DETECT_FILTER_INTEG_MAX     (4U)   /* integrator rail, LOW needs that many net LOW samples */
+
+/* P1.3 HIGH while the filter stage runs : scope the pulse width for the per-tick cost
+   (P1.3 carries no PWM0 channel, P1.2 is PWM0_CH0) */
+// #define ENABLE_DETECT_FILTER_PROFILE
+
+#if (DETECT_FILTER_TYPE == DETECT_FILTER_MAJORITY)
+#define DETECT_FILTER_DELAY_TICKS   (DETECT_FILTER_N - 1U)
+#define DETECT_FILTER_SETTLE_TICKS  (DETECT_FILTER_M)
+#elif (DETECT_FILTER_TYPE == DETECT_FILTER_INTEGRATOR)
+#define DETECT_FILTER_DELAY_TICKS   (DETECT_FILTER_INTEG_MAX - 1U)
+#define DETECT_FILTER_SETTLE_TICKS  (DETECT_FILTER_INTEG_MAX * 2U)
+#else
+#define DETECT_FILTER_DELAY_TICKS   (0U)
+#endif
+
+#if (DETECT_FILTER_TYPE != DETECT_FILTER_NONE) && (DETECT_EDGE_MODE == DETECT_EDGE_MODE_PIT)
+#error "detect filter needs DETECT_EDGE_MODE_INT1 (PIT mode ends the window on the raw rising edge)"
+#endif
 /*_____ M A C R O S ________________________________________________________*/
 
 /*_____ F U N C T I O N S __________________________________________________*/
 
-/* reset LOW-window calibration (re-measure Tlow when power-on or needed) */
+/* reset LOW-window calibration (re-measure Tlow when power-on or needed)
+ * request only : ISR applies it between windows, no global interrupt masking */
 void Reset_EINT_calibration(void);
 
-/* set duty in percent (0..100); safe to call in main loop */
+/* set duty in percent (0..100) of both half windows; lock-free, call from main loop only (single writer) */
 void PWM_SetDutyPercent(unsigned int duty_percent_input);
 
+/* set duty of one half window (DETECT_HALF_LOW / DETECT_HALF_HIGH), main loop only */
+void PWM_SetHalfDutyPercent(unsigned char half, unsigned int duty_percent_input);
+
+/* same in 0.01 % units (0..10000) */
+void PWM_SetDuty10000(unsigned int duty_percent_input);
+void PWM_SetHalfDuty10000(unsigned char half, unsigned int duty_percent_input);
+
+/* DETECT_DUTY_CURVE applied to a 0..10000 command, main loop only */
+unsigned int Duty_Curve(unsigned int duty);
+
+/* round(duty * period / DUTY_RESOLUTION_HI) with recip = DUTY_RECIP_Q16(period), main loop only */
+unsigned int Duty_Scale(unsigned int duty, unsigned int period, unsigned long recip);
+
+/* enable / disable the output pulse of one half window, applied at the next half window start */
+void PWM_SetHalfEnable(unsigned char half, unsigned char enable);
+
+/* max duty change per (half) window (0 = off), ramp computed by Detect_Process() in the main loop */
+void PWM_SetSlewStep(unsigned int step);
+
+/* DETECT_OUTPUT_LEADING / DETECT_OUTPUT_TRAILING / DETECT_OUTPUT_BURST, applied at the next half window start */
+void PWM_SetOutputMode(unsigned char mode);
+
+/* burst schedule (count pulses, width / gap in 100us ticks), main loop only, applied at the next window start */
+void PWM_SetBurst(unsigned char count, unsigned int width, unsigned int gap);
+
+/* main loop : step the duty slew limiter, precompute the P1.5 HIGH ticks of both halves for the current calibration,
+   keeps the 32-bit divide out of the 100us ISR */
+void Detect_Process(void);
+
 /* called from Timer1 100us ISR */
 void output_pulse_irq(void);
 
-/* called from INT1 ISR (falling edge on P1.7) */
+/* called from INT1 ISR or pin ISR (falling edge on P1.7) */
 void input_pulse_irq(void);
 
-/* configure INT1 (P1.7) and P1.5 output */
+#if (DETECT_EDGE_MODE == DETECT_EDGE_MODE_PIT)
+/* called from pin ISR (rising edge on P1.7) */
+void input_rise_irq(void);
+#endif
+
+/* configure INT1 or pin interrupt (P1.7) and P1.5 output */
 void EINT1_Init(void);
 
+/* main loop : pick the dominant LOW width once learning is done (no-op otherwise) */
+void Detect_AutoRange_process(void);
+
+/* main loop : drop the learned window and learn the input range again */
+void Detect_AutoRange_Restart(void);
+
+/* P1.5 level (0/1) driven while the detect input is lost */
+void Detect_SetFailsafeLevel(unsigned char level);
+
+/* max consecutive windows synthesized through input dropouts (0 = flywheel off) */
+void Detect_SetFlywheelMaxMiss(unsigned char max_miss);
+
+/* consistent copy of g_DetectMetrics (main loop, no interrupt masking) */
+void Detect_Metrics_Snapshot(DETECT_METRICS_T *p_metrics);
+
+/* print all health counters (main loop) */
+void Detect_Metrics_Dump(void);
+
+/* consistent copy of g_DetectStats for the main loop */
+void Detect_Stats_Snapshot(DETECT_STATS_T *p_stats);
+
+/* print statistics and histogram (main loop) */
+void Detect_Stats_Dump(void);
+
+/* ask the ISR to clear statistics and histogram at the next window end */
+void Detect_Stats_Clear(void);
+
+/* arm the recorder : freeze DETECT_TRACE_POST events after the next trigger event */
+void Detect_Trace_Arm(unsigned char trigger);
+
+/* print the recorder oldest first (main loop), recording pauses during the dump */
+void Detect_Trace_Dump(void);
+
 /* return frequency*100 (e.g. 5000 = 50.00 Hz) using fixed_low_ticks when ready */
 void Detect_GetFreq_log(void);
 
@@ -0,0 +1,42 @@
+/* generated by tools/gen_duty_curve.py --gamma 2.20 , do not edit */
+/* command 0..100 % -> output duty 0..10000, include from detect_pulse.c only */
+#ifndef __DUTY_CURVE_H__
+#define __DUTY_CURVE_H__
+
+#define DUTY_CURVE_POINTS           (101U)
+
+#if (DETECT_DUTY_CURVE == DUTY_CURVE_GAMMA)
+/* out = cmd ^ 2.20 */
+static unsigned int code duty_curve_table[DUTY_CURVE_POINTS] =
+{
+        0U,     0U,     2U,     4U,     8U,    14U,    21U,    29U,    39U,    50U,
+       63U,    78U,    94U,   112U,   132U,   154U,   177U,   203U,   230U,   259U,
+      290U,   323U,   358U,   394U,   433U,   474U,   516U,   561U,   608U,   657U,
+      707U,   760U,   815U,   872U,   932U,   993U,  1056U,  1122U,  1190U,  1260U,
+     1332U,  1406U,  1483U,  1562U,  1643U,  1726U,  1812U,  1899U,  1989U,  2082U,
+     2176U,  2273U,  2373U,  2474U,  2578U,  2684U,  2793U,  2904U,  3017U,  3132U,
+     3250U,  3371U,  3494U,  3619U,  3746U,  3876U,  4009U,  4143U,  4281U,  4420U,
+     4563U,  4707U,  4854U,  5004U,  5156U,  5310U,  5468U,  5627U,  5789U,  5954U,
+     6121U,  6290U,  6462U,  6637U,  6814U,  6994U,  7176U,  7361U,  7549U,  7739U,
+     7931U,  8126U,  8324U,  8524U,  8727U,  8933U,  9141U,  9352U,  9565U,  9781U,
+    10000U
+};
+#elif (DETECT_DUTY_CURVE == DUTY_CURVE_SINE_POWER)
+/* conduction phase giving cmd of the full half wave power, resistive load */
+static unsigned int code duty_curve_table[DUTY_CURVE_POINTS] =
+{
+        0U,  1160U,  1469U,  1690U,  1868U,  2020U,  2154U,  2276U,  2388U,  2492U,
+     2589U,  2681U,  2769U,  2853U,  2933U,  3010U,  3085U,  3158U,  3228U,  3296U,
+     3363U,  3428U,  3492U,  3555U,  3616U,  3676U,  3736U,  3794U,  3851U,  3908U,
+     3964U,  4020U,  4074U,  4129U,  4182U,  4235U,  4288U,  4341U,  4393U,  4444U,
+     4496U,  4547U,  4598U,  4649U,  4699U,  4749U,  4800U,  4850U,  4900U,  4950U,
+     5000U,  5050U,  5100U,  5150U,  5200U,  5251U,  5301U,  5351U,  5402U,  5453U,
+     5504U,  5556U,  5607U,  5659U,  5712U,  5765U,  5818U,  5871U,  5926U,  5980U,
+     6036U,  6092U,  6149U,  6206U,  6264U,  6324U,  6384U,  6445U,  6508U,  6572U,
+     6637U,  6704U,  6772U,  6842U,  6915U,  6990U,  7067U,  7147U,  7231U,  7319U,
+     7411U,  7508U,  7612U,  7724U,  7846U,  7980U,  8132U,  8310U,  8531U,  8840U,
+    10000U
+};
+#endif
+
+#endif /* __DUTY_CURVE_H__ */
@@ -0,0 +1,245 @@
+/*_____ I N C L U D E S ____________________________________________________*/
+#include <stdio.h>
+
+#include "numicro_8051.h"
+
+#include "freq_meter.h"
+
+/*_____ D E C L A R A T I O N S ____________________________________________*/
+
+/*_____ D E F I N I T I O N S ______________________________________________*/
+volatile FREQ_METER_MANAGER_T g_FreqMeterManager =
+{
+    {(unsigned long)FREQ_METER_GATE_MS_DEFAULT * FREQ_METER_CLOCK_KHZ,
+     (unsigned long)FREQ_METER_GATE_MS_DEFAULT * FREQ_METER_CLOCK_KHZ},  /* gate_counts */
+    0U,               /* gate_idx */
+    0UL,              /* acc_counts */
+    0U,               /* acc_periods */
+    0U,               /* edge_stamp */
+    0U,               /* last_stamp */
+    0U,               /* last_tick */
+    0U,               /* active */
+
+    0UL,              /* pub_counts */
+    0U,               /* pub_periods */
+    0U,               /* pub_seq */
+
+    0U,               /* seq_seen */
+    0UL,              /* freq_x100 */
+    0U                /* gates */
+};
+
+/*_____ M A C R O S ________________________________________________________*/
+
+/*_____ F U N C T I O N S __________________________________________________*/
+
+#if defined (ENABLE_FREQ_METER)
+/* one whole period of counts, ISR side (Timer1 ISR in software mode, capture ISR otherwise) */
+static void freq_meter_accumulate(unsigned int counts)
+{
+    g_FreqMeterManager.acc_counts += counts;
+    g_FreqMeterManager.acc_periods++;
+
+    /* close the gate early rather than wrap the 16 bit period count (fast input, long gate) */
+    if ((g_FreqMeterManager.acc_counts >= g_FreqMeterManager.gate_counts[g_FreqMeterManager.gate_idx]) ||
+        (g_FreqMeterManager.acc_periods == 0xFFFFU))
+    {
+        g_FreqMeterManager.pub_counts  = g_FreqMeterManager.acc_counts;
+        g_FreqMeterManager.pub_periods = g_FreqMeterManager.acc_periods;
+        g_FreqMeterManager.pub_seq++;
+
+        /* next gate starts on this edge, no dead time */
+        g_FreqMeterManager.acc_counts  = 0UL;
+        g_FreqMeterManager.acc_periods = 0U;
+    }
+}
+#endif
+
+#if defined (ENABLE_FREQ_METER) && (FREQ_METER_SOURCE == FREQ_METER_SRC_SOFTWARE)
+void FreqMeter_Edge_irq(unsigned int tick)
+{
+    unsigned int stamp;
+
+    stamp = g_FreqMeterManager.edge_stamp;
+
+    /* more than one Timer2 wrap since the previous edge : 16 bit difference is ambiguous */
+    if ((g_FreqMeterManager.active != 0U) &&
+        ((unsigned int)(tick - g_FreqMeterManager.last_tick) < FREQ_METER_WRAP_TICKS))
+    {
+        freq_meter_accumulate((unsigned int)(stamp - g_FreqMeterManager.last_stamp));
+    }
+    else
+    {
+        g_FreqMeterManager.acc_counts  = 0UL;
+        g_FreqMeterManager.acc_periods = 0U;
+        g_FreqMeterManager.active      = 1U;
+    }
+
+    g_FreqMeterManager.last_stamp = stamp;
+    g_FreqMeterManager.last_tick  = tick;
+}
+#endif
+
+#if defined (ENABLE_FREQ_METER) && (FREQ_METER_SOURCE == FREQ_METER_SRC_CAPTURE)
+void Capture_ISR(void) interrupt 12      // Vector @  0x63
+{
+    unsigned int counts;
+
+    _push_(SFRS);
+
+    SFRS = 0;
+    counts = ((unsigned int)C0H << 8) | C0L;
+    clr_CAPCON0_CAPF0;
+
+    if (TF2 != 0)
+    {
+        /* Timer2 wrapped inside this period (input < 23 Hz) : drop the gate */
+        clr_T2CON_TF2;
+        g_FreqMeterManager.active = 0U;
+    }
+    else if (g_FreqMeterManager.active != 0U)
+    {
+        freq_meter_accumulate(counts);
+    }
+    else
+    {
+        /* first capture only closes the partial period since Timer2 start */
+        g_FreqMeterManager.acc_counts  = 0UL;
+        g_FreqMeterManager.acc_periods = 0U;
+        g_FreqMeterManager.active      = 1U;
+    }
+
+    _pop_(SFRS);
+}
+#endif
+
+void FreqMeter_Init(void)
+{
+    #if defined (ENABLE_FREQ_METER)
+    SFRS = 0;
+    RCMP2H = 0;
+    RCMP2L = 0;
+    TH2 = 0;
+    TL2 = 0;
+    clr_T2CON_CMRL2;                    //auto-reload / capture mode
+
+        #if (FREQ_METER_SOURCE == FREQ_METER_SRC_CAPTURE)
+    /* same as TIMER2_Capture(IC0, CaptureFalling, 2) : Timer2 reloaded to 0 on each capture,
+       C0H:C0L = one whole period */
+    T2MOD = 0x89U | FREQ_METER_T2MOD_DIV;
+    CAPCON3 = (CAPCON3 & 0xF0U) | FREQ_METER_CAP_PIN_SEL;
+    CAPCON1 &= 0xFC;                    //IC0 falling edge
+    set_CAPCON2_ENF0;                   //IC0 noise filter
+    set_CAPCON0_CAPEN0;
+    C0H = 0;
+    C0L = 0;
+    clr_CAPCON0_CAPF0;
+    SET_INT_CAPTURE_LEVEL2;             //below Timer1 / edge ISR : C0H:C0L holds until the next edge
+    set_EIE_ECAP;
+        #else
+    /* free running 16 bit, no interrupt : stamped by the edge ISR */
+    T2MOD = FREQ_METER_T2MOD_DIV;
+        #endif
+
+    clr_T2CON_TF2;
+    set_T2CON_TR2;
+    #endif
+}
+
+void FreqMeter_SetGateMs(unsigned int ms)
+{
+    unsigned char next;
+    unsigned long counts;
+
+    if (ms == 0U)
+    {
+        ms = 1U;
+    }
+    else if (ms > FREQ_METER_GATE_MS_MAX)
+    {
+        ms = FREQ_METER_GATE_MS_MAX;
+    }
+    counts = (unsigned long)ms * FREQ_METER_CLOCK_KHZ;
+
+    /* 32 bit value read by the ISR : fill the slot it is not reading, then publish it with a
+       single byte write (same scheme as the detect duty_stage, no EA = 0) */
+    next = g_FreqMeterManager.gate_idx ^ 1U;
+    g_FreqMeterManager.gate_counts[next] = counts;
+    g_FreqMeterManager.gate_idx = next;
+}
+
+void FreqMeter_Process(void)
+{
+    unsigned char seq;
+    unsigned long counts;
+    unsigned int periods;
+    unsigned long num;
+    unsigned long rem;
+    unsigned long freq;
+    unsigned char i;
+
+    seq = g_FreqMeterManager.pub_seq;
+    if (seq == g_FreqMeterManager.seq_seen)
+    {
+        return;
+    }
+
+    counts  = g_FreqMeterManager.pub_counts;
+    periods = g_FreqMeterManager.pub_periods;
+    if (seq != g_FreqMeterManager.pub_seq)
+    {
+        return;     /* published again while reading : take it next loop */
+    }
+    g_FreqMeterManager.seq_seen = seq;
+
+    if (counts == 0UL)
+    {
+        return;
+    }
+
+    /* periods * 1.5M overflows 32 bit past 2863 periods : never form it. periods * 1500
+       fits (< 98.3M for any 16 bit count), the remaining x1000 of the clock and the two
+       decimals come one digit at a time from the remainder, rem * 10 < 10 * counts
+       (< 2^32 while counts < 429M, the longest gate is 90M + one period) */
+    num  = (unsigned long)periods * FREQ_METER_CLOCK_KHZ;
+    freq = num / counts;
+    rem  = num % counts;
+    for (i = 0U; i < 5U; i++)
+    {
+        rem *= 10UL;
+        freq = (freq * 10UL) + (rem / counts);
+        rem %= counts;
+    }
+    /* round half up on the third decimal */
+    if ((rem * 10UL) / counts >= 5UL)
+    {
+        freq++;
+    }
+
+    g_FreqMeterManager.freq_x100 = freq;
+    g_FreqMeterManager.gates++;
+}
+
+unsigned long FreqMeter_GetFreq_x100(void)
+{
+    return g_FreqMeterManager.freq_x100;
+}
+
+void FreqMeter_log(void)
+{
+    unsigned long freq;
+
+    freq = g_FreqMeterManager.freq_x100;
+    if (freq == 0UL)
+    {
+        printf("Freq: no gate completed yet\r\n");
+        return;
+    }
+
+    printf("Freq: %lu.%02lu Hz (%u periods, %lu counts @1.5MHz, gates=%u)\r\n",
+           freq / 100UL,
+           freq % 100UL,
+           g_FreqMeterManager.pub_periods,
+           g_FreqMeterManager.pub_counts,
+           g_FreqMeterManager.gates);
+}
@@ -0,0 +1,103 @@
+#ifndef __FREQ_METER_H__
+#define __FREQ_METER_H__
+
+/*_____ I N C L U D E S ____________________________________________________*/
+
+/*_____ D E C L A R A T I O N S ____________________________________________*/
+
+/*_____ D E F I N I T I O N S ______________________________________________*/
+
+/* reciprocal counting : a whole number of input periods is timed against Timer2,
+   freq = periods * FREQ_METER_CLOCK_HZ / counts, resolution no longer tied to the 100us tick
+   (evaluated digit by digit, the full product does not fit 32 bit ; a gate also closes at
+   65535 periods) */
+#define ENABLE_FREQ_METER
+
+#define FREQ_METER_SRC_SOFTWARE     (0U)   /* Timer2 free running, TH2:TL2 stamped in the edge ISR (P1.7) */
+#define FREQ_METER_SRC_CAPTURE      (1U)   /* Timer2 input capture IC0, period latched by hardware */
+#define FREQ_METER_SOURCE           (FREQ_METER_SRC_SOFTWARE)
+
+/* Timer2 DIV16 : 24MHz / 16 = 1.5MHz, 16 bit wrap every 43.69 ms -> input >= 23 Hz */
+#define FREQ_METER_CLOCK_HZ         (1500000UL)
+#define FREQ_METER_CLOCK_KHZ        (FREQ_METER_CLOCK_HZ / 1000UL)
+#define FREQ_METER_T2MOD_DIV        (0x20U)     /* T2MOD[6:4] = 010 : DIV16 */
+#define FREQ_METER_WRAP_TICKS       (436U)      /* 100us ticks in one Timer2 wrap */
+
+/* gate : periods are accumulated until the gate time is reached (update rate vs resolution)
+   1 s gate at 50 Hz : 1.5M counts, 1 count = 0.0001 % */
+#define FREQ_METER_GATE_MS_DEFAULT  (1000U)
+#define FREQ_METER_GATE_MS_MAX      (60000U)    /* 90M counts : rem * 10 stays below 2^32 in the main loop */
+
+/* capture source : CAPCON3[3:0] IC0 pin select (0000 : P1.2), the detect signal has to be
+   wired to that pin as well */
+#define FREQ_METER_CAP_PIN_SEL      (0x00U)
+
+typedef struct _freq_meter_manager_t
+{
+    unsigned long gate_counts[2];   /* [slot] gate in Timer2 counts, FreqMeter_SetGateMs() fills the slot ISR is not reading */
+    unsigned char gate_idx;         /* slot published to the ISR (0/1), flipped after the write */
+    unsigned long acc_counts;       /* ISR : Timer2 counts since the gate opened */
+    unsigned int acc_periods;       /* ISR : whole periods since the gate opened */
+    unsigned int edge_stamp;        /* software : TH2:TL2 at the last falling edge */
+    unsigned int last_stamp;        /* software : TH2:TL2 at the previous committed edge */
+    unsigned int last_tick;         /* software : tick100us at the previous committed edge */
+    unsigned char active;           /* 1: last_stamp valid, 0: next edge opens a new gate */
+
+    unsigned long pub_counts;       /* published : counts over pub_periods */
+    unsigned int pub_periods;       /* published : periods in pub_counts */
+    unsigned char pub_seq;          /* bumped after pub_counts / pub_periods are written */
+
+    unsigned char seq_seen;         /* main loop : pub_seq already converted */
+    unsigned long freq_x100;        /* main loop : last frequency, 0.01 Hz units, 0 = none yet */
+    unsigned int gates;             /* main loop : gates converted */
+}FREQ_METER_MANAGER_T;
+
+extern volatile FREQ_METER_MANAGER_T g_FreqMeterManager;
+
+/*_____ M A C R O S ________________________________________________________*/
+
+/* edge ISR, falling edge that may start a window : stamp Timer2 as early as possible,
+   TH2 read twice so a TL2 carry between the two reads is not mixed in
+   SFR page 0 selected by the caller (0xCC / 0xCD are PWM4L / PWM5L on page 1) */
+#if defined (ENABLE_FREQ_METER) && (FREQ_METER_SOURCE == FREQ_METER_SRC_SOFTWARE)
+#define FREQ_METER_EDGE_STAMP()                                                     \
+    do {                                                                            \
+        unsigned char _h = TH2;                                                     \
+        unsigned char _l = TL2;                                                     \
+        if (TH2 != _h) { _h = TH2; _l = TL2; }                                      \
+        g_FreqMeterManager.edge_stamp = ((unsigned int)_h << 8) | _l;               \
+    } while (0)
+/* Timer1 ISR, window confirmed : the stamped edge was a real one */
+#define FREQ_METER_EDGE_COMMIT(tick)    FreqMeter_Edge_irq(tick)
+#else
+#define FREQ_METER_EDGE_STAMP()
+#define FREQ_METER_EDGE_COMMIT(tick)
+#endif
+
+/* synthesized window / calibration reset : next real edge opens a new gate */
+#if defined (ENABLE_FREQ_METER)
+#define FREQ_METER_RESTART()        (g_FreqMeterManager.active = 0U)
+#else
+#define FREQ_METER_RESTART()
+#endif
+
+/*_____ F U N C T I O N S __________________________________________________*/
+
+/* Timer2 (and IC0 in capture mode) setup, gate = FREQ_METER_GATE_MS_DEFAULT */
+void FreqMeter_Init(void);
+
+/* Timer1 ISR only : the window started at the last stamped edge is confirmed */
+void FreqMeter_Edge_irq(unsigned int tick);
+
+/* gate time in ms (1..FREQ_METER_GATE_MS_MAX), takes effect from the next gate ; main loop only */
+void FreqMeter_SetGateMs(unsigned int ms);
+
+/* main loop : convert a newly published gate */
+void FreqMeter_Process(void);
+
+/* last measured frequency in 0.01 Hz, 0 = no gate completed yet */
+unsigned long FreqMeter_GetFreq_x100(void);
+
+void FreqMeter_log(void);
+
+#endif //__FREQ_METER_H__
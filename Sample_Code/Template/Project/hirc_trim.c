@@ -0,0 +1,163 @@
+/*_____ I N C L U D E S ____________________________________________________*/
+#include <stdio.h>
+
+#include "numicro_8051.h"
+
+#include "detect_pulse.h"
+#include "hirc_trim.h"
+
+/*_____ D E C L A R A T I O N S ____________________________________________*/
+
+/*_____ D E F I N I T I O N S ______________________________________________*/
+volatile HIRC_TRIM_MANAGER_T g_HircTrimManager =
+{
+    0U,               /* factory_trim */
+    0U,               /* trim */
+    0U,               /* nominal_hz */
+    0,                /* err_x10000 */
+    0,                /* pending_dir */
+    0U,               /* confirm_cnt */
+    0U,               /* settle */
+    0U,               /* span_seq */
+    0U,               /* steps */
+    0U                /* rejects */
+};
+
+/*_____ M A C R O S ________________________________________________________*/
+
+/*_____ F U N C T I O N S __________________________________________________*/
+
+/* RCTRIM0 = trim[8:1], RCTRIM1.0 = trim[0], both TA protected */
+static void hirc_trim_write(unsigned int trim)
+{
+    BIT_TMP = EA;
+    EA = 0;
+    TA = 0xAA;
+    TA = 0x55;
+    RCTRIM0 = (unsigned char)(trim >> 1);
+    TA = 0xAA;
+    TA = 0x55;
+    RCTRIM1 = (unsigned char)(trim & 0x01U);
+    EA = BIT_TMP;
+}
+
+void Hirc_Trim_Init(void)
+{
+    unsigned int trim;
+
+    trim = ((unsigned int)RCTRIM0 << 1) | (RCTRIM1 & 0x01U);
+
+    g_HircTrimManager.factory_trim = trim;
+    g_HircTrimManager.trim         = trim;
+    g_HircTrimManager.span_seq     = g_DetectPulseManager.span_seq;
+}
+
+void Hirc_Trim_Process(void)
+{
+#if defined (ENABLE_HIRC_TRIM) && defined (ENABLE_DETECT_SPAN)
+    unsigned char seq;
+    unsigned int span;
+    unsigned int periods;
+    unsigned long nominal;
+    long err;
+    signed char dir;
+    unsigned int trim;
+
+    seq = g_DetectPulseManager.span_seq;
+    if (seq == g_HircTrimManager.span_seq)
+    {
+        return;
+    }
+
+    span    = g_DetectPulseManager.span_ticks;
+    periods = g_DetectPulseManager.span_periods;
+    if (seq != g_DetectPulseManager.span_seq)
+    {
+        return;     /* published again while reading : take it next loop */
+    }
+    g_HircTrimManager.span_seq = seq;
+
+    if (g_HircTrimManager.settle != 0U)
+    {
+        g_HircTrimManager.settle--;
+        return;
+    }
+
+    /* nominal = periods * 10000 ticks / f_ref ; a span off by more than the tolerance is not
+       the reference (input lost, other source) : never trim on it */
+    nominal = (((unsigned long)periods * 10000UL) + (HIRC_TRIM_REF_HZ / 2U)) / HIRC_TRIM_REF_HZ;
+    err = ((long)span - (long)nominal) * 10000L / (long)nominal;
+    if ((err > HIRC_TRIM_TOLERANCE_X10000) || (err < -HIRC_TRIM_TOLERANCE_X10000))
+    {
+        g_HircTrimManager.nominal_hz  = 0U;
+        g_HircTrimManager.rejects++;
+        g_HircTrimManager.confirm_cnt = 0U;
+        return;
+    }
+    g_HircTrimManager.nominal_hz = HIRC_TRIM_REF_HZ;
+    g_HircTrimManager.err_x10000 = (int)err;
+
+    /* span longer than nominal : ticks come too fast, HIRC high -> lower it */
+    if (g_HircTrimManager.err_x10000 > HIRC_TRIM_DEADBAND_X10000)
+    {
+        dir = -HIRC_TRIM_SIGN;
+    }
+    else if (g_HircTrimManager.err_x10000 < -HIRC_TRIM_DEADBAND_X10000)
+    {
+        dir = HIRC_TRIM_SIGN;
+    }
+    else
+    {
+        g_HircTrimManager.confirm_cnt = 0U;
+        return;
+    }
+
+    if (dir != g_HircTrimManager.pending_dir)
+    {
+        g_HircTrimManager.pending_dir = dir;
+        g_HircTrimManager.confirm_cnt = 0U;
+    }
+    if (++g_HircTrimManager.confirm_cnt < HIRC_TRIM_CONFIRM)
+    {
+        return;
+    }
+    g_HircTrimManager.confirm_cnt = 0U;
+
+    /* one LSB per step, kept around the factory value */
+    trim = g_HircTrimManager.trim;
+    if (dir > 0)
+    {
+        if ((trim >= 0x1FFU) ||
+            (trim >= (g_HircTrimManager.factory_trim + HIRC_TRIM_MAX_DELTA)))
+        {
+            return;
+        }
+        trim++;
+    }
+    else
+    {
+        if ((trim == 0U) ||
+            ((trim + HIRC_TRIM_MAX_DELTA) <= g_HircTrimManager.factory_trim))
+        {
+            return;
+        }
+        trim--;
+    }
+
+    hirc_trim_write(trim);
+    g_HircTrimManager.trim   = trim;
+    g_HircTrimManager.settle = HIRC_TRIM_SETTLE_SPANS;
+    g_HircTrimManager.steps++;
+#endif
+}
+
+void Hirc_Trim_log(void)
+{
+    printf("HIRC: trim=%u (factory %u) ref=%uHz err=%d/10000 steps=%u rejects=%u\r\n",
+           g_HircTrimManager.trim,
+           g_HircTrimManager.factory_trim,
+           (unsigned int)g_HircTrimManager.nominal_hz,
+           g_HircTrimManager.err_x10000,
+           g_HircTrimManager.steps,
+           g_HircTrimManager.rejects);
+}
@@ -0,0 +1,59 @@
+#ifndef __HIRC_TRIM_H__
+#define __HIRC_TRIM_H__
+
+/*_____ I N C L U D E S ____________________________________________________*/
+
+/*_____ D E C L A R A T I O N S ____________________________________________*/
+
+/*_____ D E F I N I T I O N S ______________________________________________*/
+
+typedef struct _hirc_trim_manager_t
+{
+    unsigned int factory_trim;      /* 9-bit trim loaded by MODIFY_HIRC_24() */
+    unsigned int trim;              /* 9-bit trim in RCTRIM0 / RCTRIM1 now */
+    unsigned char nominal_hz;       /* HIRC_TRIM_REF_HZ when the last span matched it, 0 = rejected */
+    int err_x10000;                 /* last span error, 0.01 % units, > 0 : HIRC fast */
+    signed char pending_dir;        /* direction of the last out-of-deadband error (+1 / -1) */
+    unsigned char confirm_cnt;      /* consecutive spans asking for the same direction */
+    unsigned char settle;           /* spans to skip after a trim change (span straddles it) */
+    unsigned char span_seq;         /* last g_DetectPulseManager.span_seq consumed */
+    unsigned int steps;             /* trim changes applied */
+    unsigned int rejects;           /* spans outside the reference tolerance */
+}HIRC_TRIM_MANAGER_T;
+
+extern volatile HIRC_TRIM_MANAGER_T g_HircTrimManager;
+
+/* closed loop HIRC trim against the detect input used as mains reference
+   needs ENABLE_DETECT_SPAN in detect_pulse.h ; grid frequency (typ. +/-0.1 % long term)
+   is the accuracy limit
+   opt-in : only for an input that really is the mains (or its full wave rectified image),
+   any other source (a 52 Hz generator ...) would drag HIRC off by up to HIRC_TRIM_MAX_DELTA */
+// #define ENABLE_HIRC_TRIM
+
+/* the reference, set explicitly : 50 / 60 Hz, or 100 / 120 Hz after a full wave rectifier */
+#define HIRC_TRIM_REF_HZ            (50U)
+
+#define HIRC_TRIM_TOLERANCE_X10000  (300)  /* span within +/-3 % of the reference, else rejected */
+#define HIRC_TRIM_LSB_X10000        (25)   /* one RCTRIM LSB moves HIRC by ~0.25 % (typ.) */
+#define HIRC_TRIM_DEADBAND_X10000   (HIRC_TRIM_LSB_X10000)  /* >= one LSB : no hunting between two codes */
+#define HIRC_TRIM_CONFIRM           (2U)   /* same direction on consecutive spans before a step */
+#define HIRC_TRIM_MAX_DELTA         (24U)  /* trim kept within factory +/- this many LSB */
+#define HIRC_TRIM_SETTLE_SPANS      (1U)   /* spans dropped after each step */
+
+/* +1 : a higher RCTRIM value raises the HIRC frequency */
+#define HIRC_TRIM_SIGN              (1)
+
+/*_____ M A C R O S ________________________________________________________*/
+
+/*_____ F U N C T I O N S __________________________________________________*/
+
+/* read the trim loaded by MODIFY_HIRC_24() as the factory reference (call once after it) */
+void Hirc_Trim_Init(void);
+
+/* main loop : consume a new period span, step RCTRIM toward HIRC_TRIM_REF_HZ */
+void Hirc_Trim_Process(void);
+
+/* print trim state (main loop) */
+void Hirc_Trim_log(void);
+
+#endif //__HIRC_TRIM_H__
@@ -4,16 +4,14 @@
 #include "misc_config.h"
 
 #include "detect_pulse.h"
+#include "hirc_trim.h"
+#include "freq_meter.h"
+#include "pwm_ctrl.h"
+#include "pwm_play.h"
+#include "pwm_brake.h"
+#include "timebase.h"
 /*_____ D E C L A R A T I O N S ____________________________________________*/
 
-#define TIMER_DIV12_1ms_FOSC_240000  			(65536-2000)
-#define TH0_INIT        						(HIBYTE(TIMER_DIV12_1ms_FOSC_240000)) 
-#define TL0_INIT        						(LOBYTE(TIMER_DIV12_1ms_FOSC_240000))
-
-#define TIMER_DIV12_100us_FOSC_240000  			(65536-200)
-#define TH1_INIT        						(HIBYTE(TIMER_DIV12_100us_FOSC_240000)) 
-#define TL1_INIT        						(LOBYTE(TIMER_DIV12_100us_FOSC_240000))
-
 //UART 0
 bit BIT_TMP;
 bit BIT_UART;
@@ -31,32 +29,8 @@ volatile struct flag_32bit flag_PROJ_CTL;
 #define FLAG_PROJ_REVERSE7                              (flag_PROJ_CTL.bit7)
 
 
-#define UDIV_ROUND_NEAREST(a,b) 						( ((unsigned long)(a) + ((unsigned long)(b)/2u)) / (unsigned long)(b) )
-
-/*
-	100 Hz
-	24MHz / 128 = 187,500 Hz; 
-	187,500 / 100 Hz = 1,875 ticks → PERIOD=1875-1
-
-
-	60 Hz
-	24MHz / 128 = 187,500 Hz; 
-	187,500 / 60 Hz = 3125 ticks → PERIOD=3125-1
-
-	50 Hz
-	24MHz / 128 = 187,500 Hz; 
-	187,500 / 50 Hz = 3750 ticks → PERIOD=3750-1
-*/
-
-#define PWM_BASE_FREQ_HZ        						(100u)
-// #define PWM_BASE_FREQ_HZ        						(120u)
-#define PWM_DIV_FOR_FREQ      							(128u)
-#define PWM_PERIOD_TICKS        						((SYS_CLOCK / PWM_DIV_FOR_FREQ) / PWM_BASE_FREQ_HZ)
-
-
 /*_____ D E F I N I T I O N S ______________________________________________*/
 
-volatile uint32_t counter_tick = 0;
 
 /*_____ M A C R O S ________________________________________________________*/
 #define SYS_CLOCK 										(24000000ul)
@@ -65,21 +39,6 @@ volatile uint32_t counter_tick = 0;
 /*_____ F U N C T I O N S __________________________________________________*/
 
 
-static uint32_t get_tick(void)
-{
-	return (counter_tick);
-}
-
-static void set_tick(uint32_t t)
-{
-	counter_tick = t;
-}
-
-static void tick_counter(void)
-{
-	counter_tick++;
-}
-
 #if defined (REDUCE_CODE_SIZE)
 void send_UARTString(uint8_t* Data)
 {
@@ -177,82 +136,91 @@ void delay(uint16_t dly)
 }
 
 
-/*
-	ch : channel index
-	frequency : target frequency (unit:Hz) , ex:100 , 1000
-	duty : percent
-	resolution : 100 ~ 10000
-	
-	ex1 : 
-	target duty = 95% => duty = 95,resolution = 100
-	target duty = 87.5% => duty = 875,resolution = 1000
-	target duty = 97.75% => duty = 9775,resolution = 10000
-*/
-void pwm_channel_Init(unsigned char ch,unsigned int duty,unsigned int resolution)
+void loop(void)
 {
-	unsigned int period = PWM_PERIOD_TICKS;
-	unsigned int res = 0;
+	// static uint16_t LOG = 0;	
 
-	/*
-		set target channel and pin define
-	*/
-	switch(ch)
-	{
-		// case 0:
-		// 	P12_PUSHPULL_MODE;	//Add this to enhance MOS output capability
-		// 	ENABLE_PWM0_CH0_P12_OUTPUT;	
-		// 	break;
-		case 2:
-			P10_PUSHPULL_MODE;	//Add this to enhance MOS output capability
-			ENABLE_PWM0_CH2_P10_OUTPUT;	
-			break;
-	}
-		
-	/*
-		24M/2^7 = 24000000/128 = 187500
-		187500/freq = unsigned int	
-		FIX freq to 100Hz
-	*/
-	PWM0_IMDEPENDENT_MODE;		
-	PWM0_CLOCK_DIV_128;
-    PWMPH = HIBYTE(PWM_PERIOD_TICKS -1u);
-    PWMPL = LOBYTE(PWM_PERIOD_TICKS -1u);
+	Detect_AutoRange_process();
+	Detect_Process();
+	Hirc_Trim_Process();
+	FreqMeter_Process();
+	PWM0_Ctrl_SyncProcess();
+	PWM_Brake_Process();
 
-	/*
-		set duty
-	*/
-	// res = (unsigned long) duty*(MAKEWORD(PWMPH,PWMPL)+1)/resolution;
-	res = (unsigned int)UDIV_ROUND_NEAREST((unsigned long)duty * period, (unsigned long)resolution);
-
-	switch(ch)
+	if (uart0_receive_flag)
 	{
-		// case 0:
-		// 	PWM0H = HIBYTE(res);
-		// 	PWM0L = LOBYTE(res);
-		// 	break;
-		case 2:
-			PWM2H = HIBYTE(res);
-			PWM2L = LOBYTE(res);
-			break;		
+		uart0_receive_flag = 0;
+		switch(uart0_receive_data)
+		{
+			case 's':
+				Detect_Stats_Dump();
+				break;
+			case 'S':
+				Detect_Stats_Clear();
+				printf("Stats: clear at next window\r\n");
+				break;
+			case 'm':
+				Detect_Metrics_Dump();
+				break;
+			case 't':
+				Detect_Trace_Dump();
+				break;
+			case 'T':
+				Detect_Trace_Arm(DETECT_TRACE_TRIGGER_DEFAULT);
+				printf("Trace: armed\r\n");
+				break;
+			case 'h':
+				Hirc_Trim_log();
+				break;
+			case 'f':
+				FreqMeter_log();
+				break;
+			case 'p':
+				if (g_PwmPlayManager.active != 0U)
+				{
+					PWM_Play_Stop();
+				}
+				else
+				{
+					/* 1.00 Hz sine on PWM0_CH2 (P1.0) */
+					if (PWM_Play_Start(0x04U, PWM_Play_StepFromFreq_x100(100U), 1U) == 0U)
+					{
+						printf("Play: refused, PWM sync on or batch pending\r\n");
+					}
+				}
+				PWM_Play_log();
+				break;
+			case 'y':
+				if (PWM0_Ctrl_SetSync((g_Pwm0CtrlManager.sync_mode != 0U) ? 0U : 1U) == 0U)
+				{
+					printf("PWM sync: refused, playback running\r\n");
+				}
+				printf("PWM sync: %u\r\n", (unsigned int)g_Pwm0CtrlManager.sync_mode);
+				break;
+			case 'b':
+				PWM_Brake_log();
+				break;
+			case 'B':
+				if (PWM_Brake_Recover() == 0U)
+				{
+					printf("Brake: fault input still active\r\n");
+				}
+				PWM_Brake_log();
+				break;
+		}
 	}
 
-    set_PWMCON0_LOAD;
-    set_PWMCON0_PWMRUN;	
-}
-
-void loop(void)
-{
-	// static uint16_t LOG = 0;	
-	if (FLAG_PROJ_TIMER_PERIOD_1000MS)
+	if (g_TimebaseManager.evt_1000ms)
 	{
-		FLAG_PROJ_TIMER_PERIOD_1000MS = 0;	
+		g_TimebaseManager.evt_1000ms = 0;	
 		// printf("LOG : %4d\r\n",LOG++);
+		FreqMeter_log();
 		// P12 ^= 1;		
 	}
 
-	if (FLAG_PROJ_TIMER_PERIOD_500MS)
+	if (g_TimebaseManager.evt_500ms)
 	{
-		FLAG_PROJ_TIMER_PERIOD_500MS = 0;
+		g_TimebaseManager.evt_500ms = 0;
 		Detect_GetFreq_log();
 	}	
 }
@@ -268,98 +236,6 @@ void GPIO_Init(void)
 	P30_PUSHPULL_MODE;	
 }
 
-void Timer1_ISR(void) interrupt 3        // Vector @  0x1B
-{
-    _push_(SFRS);	
-	
-    clr_TCON_TF1;
-	TH1 = TH1_INIT;
-	TL1 = TL1_INIT;	
-		
-	// P12 ^= 1;	// for debug period
-	
-	output_pulse_irq();
-
-    _pop_(SFRS);	
-}
-
-void TIMER1_Init(void)
-{
-	/*
-		formula : 16bit 
-		(0xFFFF+1 - target)  / (24MHz/psc) = time base 
-	*/	
-	
-    TIMER1_FSYS_DIV12;
-	ENABLE_TIMER1_MODE1;	// Timer 1 as 16-bits mode
-
-	TH1 = TH1_INIT;
-	TL1 = TL1_INIT;
-	clr_TCON_TF1;
-    set_TCON_TR1;                                  //Timer1 run
-    ENABLE_TIMER1_INTERRUPT;                       //enable Timer1 interrupt
-    ENABLE_GLOBAL_INTERRUPT;                       //enable interrupts  
-
-	// SET_INT_Timer1_LEVEL0;
-	SET_INT_Timer1_LEVEL3;
-}
-
-void Timer0_IRQHandler(void)
-{
-
-	tick_counter();
-
-	if ((get_tick() % 1000) == 0)
-	{
-		FLAG_PROJ_TIMER_PERIOD_1000MS = 1;
-
-	}
-
-	if ((get_tick() % 500) == 0)
-	{
-		FLAG_PROJ_TIMER_PERIOD_500MS = 1;
-
-	}
-
-	if ((get_tick() % 50) == 0)
-	{
-
-	}		
-}
-
-void Timer0_ISR(void) interrupt 1        // Vector @  0x0B
-{
-    _push_(SFRS);	
-	
-    clr_TCON_TF0;
-	TH0 = TH0_INIT;
-	TL0 = TL0_INIT;	
-	
-	Timer0_IRQHandler();
-
-    _pop_(SFRS);	
-}
-
-void TIMER0_Init(void)
-{
-	/*
-		formula : 16bit 
-		(0xFFFF+1 - target)  / (24MHz/psc) = time base 
-	*/	
-	
-	ENABLE_TIMER0_MODE1;	// mode 0 : 13 bit , mode 1 : 16 bit
-    TIMER0_FSYS_DIV12;
-
-	TH0 = TH0_INIT;
-	TL0 = TL0_INIT;
-	clr_TCON_TF0;
-
-    set_TCON_TR0;                                  //Timer0 run
-    ENABLE_TIMER0_INTERRUPT;                       //enable Timer0 interrupt
-    ENABLE_GLOBAL_INTERRUPT;                       //enable interrupts
-  
-}
-
 void Serial_ISR (void) interrupt 4 
 {
     _push_(SFRS);
@@ -485,6 +361,7 @@ void MODIFY_HIRC_24(void)
 void SYS_Init(void)
 {
     MODIFY_HIRC_24();
+    Hirc_Trim_Init();
 
     // ALL_GPIO_QUASI_MODE;
     ENABLE_GLOBAL_INTERRUPT;                // global enable bit	
@@ -499,20 +376,25 @@ void main (void)
 	*/
     UART0_Init();
 	GPIO_Init();
-	TIMER0_Init();
 
 	/*
 		enable pin : P1.7 (EINT)
 		pulse pin : P.15 (GPIO)
 	*/
-    TIMER1_Init();
+    Timebase_Init();
 	EINT1_Init();
+	FreqMeter_Init();
 
 	/*
 		PWM pin : P1.0 (PWM0_CH2)
 	*/
 	pwm_channel_Init(2,50,100);
 
+	/*
+		brake pin : P1.4 (FB), external comparator, active LOW (ENABLE_PWM_BRAKE in pwm_brake.h)
+	*/
+	PWM_Brake_Init(PWM_BRAKE_SAFE_LEVELS, PWM_BRAKE_ACTIVE_LOW, PWM_BRAKE_AUTO);
+
 	// PWM_SetDutyPercent(20U);
 	// PWM_SetDutyPercent(25);
 	PWM_SetDutyPercent(50U);
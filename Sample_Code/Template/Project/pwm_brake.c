@@ -0,0 +1,196 @@
+/*_____ I N C L U D E S ____________________________________________________*/
+#include <stdio.h>
+
+#include "numicro_8051.h"
+
+#include "detect_pulse.h"
+#include "pwm_brake.h"
+
+/*_____ D E C L A R A T I O N S ____________________________________________*/
+
+/*_____ D E F I N I T I O N S ______________________________________________*/
+volatile PWM_BRAKE_MANAGER_T g_PwmBrakeManager =
+{
+    PWM_BRAKE_SAFE_LEVELS,  /* safe_levels */
+    PWM_BRAKE_ACTIVE_LOW,   /* active_high */
+    PWM_BRAKE_MANUAL,       /* policy */
+    0U,                     /* tripped */
+    0U,                     /* trip_tick */
+    0U,                     /* idle_tick */
+    0U,                     /* idle_valid */
+    0U,                     /* retry_cnt */
+    0U,                     /* run_tick */
+    0U,                     /* trips */
+    0U                      /* recovers */
+};
+
+/*_____ M A C R O S ________________________________________________________*/
+
+/* FB pin still asserted */
+#define PWM_BRAKE_PIN_ACTIVE()      ((g_PwmBrakeManager.active_high != 0U) ? (P14 != 0) : (P14 == 0))
+
+/*_____ F U N C T I O N S __________________________________________________*/
+
+/* main loop : tick100us is 16 bit and bumped by Timer1, mask it for the two byte read */
+static unsigned int pwm_brake_now(void)
+{
+    unsigned int now;
+
+    DISABLE_TIMER1_INTERRUPT;
+    now = g_DetectPulseManager.tick100us;
+    ENABLE_TIMER1_INTERRUPT;
+
+    return now;
+}
+
+#if defined (ENABLE_PWM_BRAKE)
+void PWM_Brake_ISR(void) interrupt 14   // Vector @  0x73
+{
+    _push_(SFRS);
+
+    /* hardware already stopped PWM0 and drives FBD ; FBF stays set (outputs held) until
+       the recovery, so mask the source instead of clearing the flag */
+    clr_EIE_EFB;
+
+    g_PwmBrakeManager.tripped    = 1U;
+    g_PwmBrakeManager.trip_tick  = g_DetectPulseManager.tick100us;   //ISR at Timer1 level : never half updated
+    g_PwmBrakeManager.idle_valid = 0U;
+    if (g_PwmBrakeManager.trips != 0xFFFFU)
+    {
+        g_PwmBrakeManager.trips++;
+    }
+
+    _pop_(SFRS);
+}
+#endif
+
+void PWM_Brake_Init(unsigned char safe_levels, unsigned char active_high, unsigned char policy)
+{
+    #if defined (ENABLE_PWM_BRAKE)
+    g_PwmBrakeManager.safe_levels = safe_levels & 0x3FU;
+    g_PwmBrakeManager.active_high = (active_high != 0U) ? 1U : 0U;
+    g_PwmBrakeManager.policy      = policy;
+    g_PwmBrakeManager.tripped     = 0U;
+    g_PwmBrakeManager.retry_cnt   = 0U;
+
+    /* FB pin P1.4 : an external comparator drives it ; active LOW idles on the internal
+       pull-up (quasi mode), active HIGH needs an external pull-down, never left floating */
+    if (g_PwmBrakeManager.active_high != 0U)
+    {
+        P14_INPUT_MODE;
+    }
+    else
+    {
+        P14_QUASI_MODE;
+        P14 = 1;
+    }
+
+    /* FBF = 0, FBINLS = trip edge, FBD[5:0] = safe levels */
+    FBD = (unsigned char)((g_PwmBrakeManager.active_high != 0U) ? 0x40U : 0x00U) |
+          g_PwmBrakeManager.safe_levels;
+    set_PWMCON1_FBINEN;
+
+    SET_INT_PWM0_BRAKE_LEVEL3;          //not delayed by the PWM period ISR
+    set_EIE_EFB;
+    #endif
+}
+
+static unsigned char pwm_brake_restart(void)
+{
+    if (g_PwmBrakeManager.tripped == 0U)
+    {
+        return 1U;
+    }
+    if (PWM_BRAKE_PIN_ACTIVE())
+    {
+        return 0U;
+    }
+
+    g_PwmBrakeManager.tripped    = 0U;
+    g_PwmBrakeManager.idle_valid = 0U;
+    g_PwmBrakeManager.run_tick   = pwm_brake_now();
+    if (g_PwmBrakeManager.recovers != 0xFFFFU)
+    {
+        g_PwmBrakeManager.recovers++;
+    }
+
+    clr_FBD_FBF;                        //release the outputs
+    set_EIE_EFB;
+    set_PWMCON0_LOAD;                   //duties / period written while braked
+    set_PWMCON0_PWMRUN;
+
+    return 1U;
+}
+
+unsigned char PWM_Brake_Recover(void)
+{
+    if (pwm_brake_restart() == 0U)
+    {
+        return 0U;
+    }
+
+    g_PwmBrakeManager.retry_cnt = 0U;   //operator cleared it : auto retries allowed again
+    return 1U;
+}
+
+void PWM_Brake_Process(void)
+{
+    unsigned int now;
+
+    if (g_PwmBrakeManager.policy != PWM_BRAKE_AUTO)
+    {
+        return;
+    }
+
+    now = pwm_brake_now();
+    if (g_PwmBrakeManager.tripped == 0U)
+    {
+        /* a clean run after an auto restart : faults days apart do not add up to a latch */
+        if ((g_PwmBrakeManager.retry_cnt != 0U) &&
+            ((unsigned int)(now - g_PwmBrakeManager.run_tick) >= PWM_BRAKE_CLEAN_TICKS))
+        {
+            g_PwmBrakeManager.retry_cnt = 0U;
+        }
+        return;
+    }
+
+    #if (PWM_BRAKE_MAX_RETRY != 0U)
+    if (g_PwmBrakeManager.retry_cnt >= PWM_BRAKE_MAX_RETRY)
+    {
+        /* repeated faults : leave it to PWM_Brake_Recover() */
+        return;
+    }
+    #endif
+
+    if (PWM_BRAKE_PIN_ACTIVE())
+    {
+        g_PwmBrakeManager.idle_valid = 0U;
+        return;
+    }
+
+    if (g_PwmBrakeManager.idle_valid == 0U)
+    {
+        g_PwmBrakeManager.idle_tick  = now;
+        g_PwmBrakeManager.idle_valid = 1U;
+        return;
+    }
+
+    if ((unsigned int)(now - g_PwmBrakeManager.idle_tick) >= PWM_BRAKE_HOLD_TICKS)
+    {
+        if (pwm_brake_restart() != 0U)
+        {
+            g_PwmBrakeManager.retry_cnt++;
+        }
+    }
+}
+
+void PWM_Brake_log(void)
+{
+    printf("Brake: %s policy=%s trips=%u recovers=%u retry=%u FBD=0x%02X\r\n",
+           (g_PwmBrakeManager.tripped != 0U) ? "TRIPPED" : "armed",
+           (g_PwmBrakeManager.policy == PWM_BRAKE_AUTO) ? "auto" : "manual",
+           g_PwmBrakeManager.trips,
+           g_PwmBrakeManager.recovers,
+           (unsigned int)g_PwmBrakeManager.retry_cnt,
+           (unsigned int)FBD);
+}
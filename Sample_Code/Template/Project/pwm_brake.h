@@ -0,0 +1,59 @@
+#ifndef __PWM_BRAKE_H__
+#define __PWM_BRAKE_H__
+
+/*_____ I N C L U D E S ____________________________________________________*/
+
+/*_____ D E C L A R A T I O N S ____________________________________________*/
+
+/*_____ D E F I N I T I O N S ______________________________________________*/
+
+/* PWM0 fault brake : an edge on the FB pin (P1.4) stops PWM0 in hardware (PWMRUN cleared,
+   outputs forced to the FBD levels) within one clock ; the ISR only records the trip
+   opt-in : needs the comparator fitted on P1.4, and P1.4 is also the PWM0_CH1 alternate pin
+   (PIOCON1, pwm_ctrl.c), keep CH1 on P1.1 while the brake is used */
+// #define ENABLE_PWM_BRAKE
+
+#define PWM_BRAKE_ACTIVE_LOW        (0U)        /* FBINLS = 0 : falling edge trips (open drain comparator), internal pull-up */
+#define PWM_BRAKE_ACTIVE_HIGH       (1U)        /* FBINLS = 1 : rising edge trips, input only : external pull-down */
+
+#define PWM_BRAKE_MANUAL            (0U)        /* stay braked until PWM_Brake_Recover() */
+#define PWM_BRAKE_AUTO              (1U)        /* main loop restarts once the pin is idle for the hold time */
+
+#define PWM_BRAKE_SAFE_LEVELS       (0x00U)     /* FBD[5:0] : level of PWM0..5 while braked, all LOW */
+#define PWM_BRAKE_HOLD_TICKS        (1000U)     /* auto : 100 ms of idle FB pin (100us ticks) before a restart */
+#define PWM_BRAKE_MAX_RETRY         (3U)        /* auto : trips before falling back to manual, 0 = no limit */
+#define PWM_BRAKE_CLEAN_TICKS       (50000U)    /* auto : 5 s without a trip after a restart clears the retries */
+
+typedef struct _pwm_brake_manager_t
+{
+    unsigned char safe_levels;      /* FBD[5:0] */
+    unsigned char active_high;      /* PWM_BRAKE_ACTIVE_LOW / _HIGH */
+    unsigned char policy;           /* PWM_BRAKE_MANUAL / _AUTO */
+    unsigned char tripped;          /* 1: ISR saw the brake, outputs held at safe_levels */
+    unsigned int trip_tick;         /* tick100us at the trip (ISR) */
+    unsigned int idle_tick;         /* tick100us the FB pin was first seen idle again (main loop) */
+    unsigned char idle_valid;       /* 1: idle_tick running */
+    unsigned char retry_cnt;        /* auto restarts since the last manual recover or clean run */
+    unsigned int run_tick;          /* tick100us of the last restart (main loop) */
+    unsigned int trips;             /* brake events (saturating) */
+    unsigned int recovers;          /* restarts, manual or auto */
+}PWM_BRAKE_MANAGER_T;
+
+extern volatile PWM_BRAKE_MANAGER_T g_PwmBrakeManager;
+
+/*_____ M A C R O S ________________________________________________________*/
+
+/*_____ F U N C T I O N S __________________________________________________*/
+
+/* FB pin input, safe levels, trip edge, policy ; brake ISR at level 3 */
+void PWM_Brake_Init(unsigned char safe_levels, unsigned char active_high, unsigned char policy);
+
+/* main loop : auto recovery policy */
+void PWM_Brake_Process(void);
+
+/* clear the brake and restart PWM0 ; returns 0 while the FB pin is still active */
+unsigned char PWM_Brake_Recover(void);
+
+void PWM_Brake_log(void);
+
+#endif //__PWM_BRAKE_H__
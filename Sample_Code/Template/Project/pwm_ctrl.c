@@ -0,0 +1,616 @@
+/*_____ I N C L U D E S ____________________________________________________*/
+#include "numicro_8051.h"
+
+#include "detect_pulse.h"
+#include "freq_meter.h"
+#include "pwm_ctrl.h"
+#include "pwm_play.h"
+
+/*_____ D E C L A R A T I O N S ____________________________________________*/
+
+/*_____ D E F I N I T I O N S ______________________________________________*/
+volatile PWM0_CTRL_MANAGER_T g_Pwm0CtrlManager =
+{
+    PWM_PERIOD_TICKS,                   /* period */
+    PWM_DUTY_RECIP_Q16,                 /* recip */
+    PWM_DIV_CODE_DEFAULT,               /* div_code */
+    PWM_BASE_FREQ_HZ,                   /* freq_hz */
+    {0U, 0U, 0U, 0U, 0U, 0U},           /* duty_x10000 */
+    0U,                                 /* sync_mode */
+    0U,                                 /* sync_gates */
+    0U,                                 /* sync_locked */
+    0U,                                 /* enable_mask */
+    {0U, 0U, 0U, 0U, 0U, 0U},           /* duty_ticks */
+    {0U, 0U, 0U, 0U, 0U, 0U},           /* stage_ticks */
+    0U,                                 /* dirty_mask */
+    0U,                                 /* play_lock */
+    0U,                                 /* div_pending */
+    0U                                  /* raw_mask */
+};
+
+/*
+	default pins, all on PIOCON0 (SFR page 0)
+	alternates on PIOCON1 (page 1) : CH1 P1.4 (0x02), CH2 P0.5 (0x04), CH3 P0.4 (0x08), CH5 P1.5 (0x20)
+	P1.5 is the detect pulse output, keep CH5 on P0.3 while detect_pulse.c drives it
+	P1.4 is the brake input (FB) when ENABLE_PWM_BRAKE is on, keep CH1 on P1.1 then
+*/
+static PWM0_CTRL_DESC_T code pwm0_ctrl_desc[PWM0_CTRL_CHANNELS] =
+{
+    /* pio_page, pio_mask, port, pin_mask */
+    {0U, 0x01U, 1U, 0x04U},             /* CH0 : P1.2 */
+    {0U, 0x02U, 1U, 0x02U},             /* CH1 : P1.1 */
+    {0U, 0x04U, 1U, 0x01U},             /* CH2 : P1.0 */
+    {0U, 0x08U, 0U, 0x01U},             /* CH3 : P0.0 */
+    {0U, 0x10U, 0U, 0x02U},             /* CH4 : P0.1 */
+    {0U, 0x20U, 0U, 0x08U}              /* CH5 : P0.3 */
+};
+
+static PWM0_FREQ_ENTRY_T code pwm0_freq_table[] =
+{
+    PWM_FREQ_ENTRY(50UL),
+    PWM_FREQ_ENTRY(60UL),
+    PWM_FREQ_ENTRY(100UL),
+    PWM_FREQ_ENTRY(120UL),
+    PWM_FREQ_ENTRY(200UL),
+    PWM_FREQ_ENTRY(400UL),
+    PWM_FREQ_ENTRY(1000UL),
+    PWM_FREQ_ENTRY(2000UL),
+    PWM_FREQ_ENTRY(5000UL),
+    PWM_FREQ_ENTRY(10000UL),
+    PWM_FREQ_ENTRY(16000UL),
+    PWM_FREQ_ENTRY(20000UL),
+    PWM_FREQ_ENTRY(25000UL)
+};
+
+#define PWM0_FREQ_TABLE_SIZE        (sizeof(pwm0_freq_table) / sizeof(pwm0_freq_table[0]))
+
+/* the default has to fit the 9 bit PDTCNT */
+PWM_STATIC_ASSERT(deadtime_default, (PWM0_DEADTIME_NS_DEFAULT > 0UL) &&
+                  (PWM_DEADTIME_COUNT(PWM0_DEADTIME_NS_DEFAULT) <= PWM_DEADTIME_COUNT_MAX));
+
+/*_____ M A C R O S ________________________________________________________*/
+
+/*_____ F U N C T I O N S __________________________________________________*/
+
+/* PWM0 period end : the divider switch of PWM0_Ctrl_SetFreq() / sync, and PWM_Play samples */
+void PWM_ISR(void) interrupt 13         // Vector @  0x6B
+{
+    _push_(SFRS);
+
+    SFRS = 0;                           //may preempt a page 1 window : PWMCON0 / TL2 (cost stamp) are page 0
+    clr_PWMCON0_PWMF;
+
+    /* LOAD cleared : the new period and duties were taken at this period end, the new clock
+       joins them here ; restart the counter so no part of a period runs on the old clock */
+    if ((g_Pwm0CtrlManager.div_pending != 0U) && (LOAD == 0))
+    {
+        PWMCON1 = (PWMCON1 & 0xF8U) | g_Pwm0CtrlManager.div_code;
+        set_PWMCON0_CLRPWM;
+        g_Pwm0CtrlManager.div_pending = 0U;
+        if (g_Pwm0CtrlManager.play_lock == 0U)
+        {
+            DISABLE_PWM0_INTERRUPT;
+        }
+    }
+
+    #if defined (ENABLE_PWM_PLAY)
+    PWM_Play_irq();
+    #endif
+
+    _pop_(SFRS);
+}
+
+void PWM0_Ctrl_Init(void)
+{
+    unsigned int period;
+
+    period = g_Pwm0CtrlManager.period;
+
+	/*
+		24M/2^7 = 24000000/128 = 187500
+		187500/freq = unsigned int
+		PWM_BASE_FREQ_HZ until PWM0_Ctrl_SetFreq()
+	*/
+    PWM0_IMDEPENDENT_MODE;
+    PWMCON1 = (PWMCON1 & 0xF8U) | g_Pwm0CtrlManager.div_code;
+    PWMPH = HIBYTE(period - 1u);
+    PWMPL = LOBYTE(period - 1u);
+}
+
+void PWM0_Ctrl_Enable(unsigned char ch)
+{
+    PWM0_CTRL_DESC_T code *d;
+
+    if (ch >= PWM0_CTRL_CHANNELS)
+    {
+        return;
+    }
+    d = &pwm0_ctrl_desc[ch];
+
+    /* push-pull : PxM1 = 0, PxM2 = 1 (enhance MOS output capability) */
+    if (d->port == 0U)
+    {
+        P0M1 &= (unsigned char)~d->pin_mask;
+        P0M2 |= d->pin_mask;
+    }
+    else
+    {
+        P1M1 &= (unsigned char)~d->pin_mask;
+        P1M2 |= d->pin_mask;
+    }
+
+    if (d->pio_page == 0U)
+    {
+        PIOCON0 |= d->pio_mask;
+    }
+    else
+    {
+        set_SFRS_SFRPAGE;
+        PIOCON1 |= d->pio_mask;
+        clr_SFRS_SFRPAGE;
+    }
+
+    g_Pwm0CtrlManager.enable_mask |= (unsigned char)(1U << ch);
+}
+
+void PWM0_Ctrl_Disable(unsigned char ch)
+{
+    PWM0_CTRL_DESC_T code *d;
+
+    if (ch >= PWM0_CTRL_CHANNELS)
+    {
+        return;
+    }
+    d = &pwm0_ctrl_desc[ch];
+
+    if (d->pio_page == 0U)
+    {
+        PIOCON0 &= (unsigned char)~d->pio_mask;
+    }
+    else
+    {
+        set_SFRS_SFRPAGE;
+        PIOCON1 &= (unsigned char)~d->pio_mask;
+        clr_SFRS_SFRPAGE;
+    }
+
+    g_Pwm0CtrlManager.enable_mask &= (unsigned char)~(1U << ch);
+}
+
+/* register write only, ch checked by the caller (duty_x10000 left to the caller) */
+static void pwm0_ctrl_write_ticks(unsigned char ch, unsigned int ticks)
+{
+    /* SFRs are direct addressed only : dense 0..5 switch, compiled to a jump table */
+    switch (ch)
+    {
+        case 0: PWM0H = HIBYTE(ticks); PWM0L = LOBYTE(ticks); break;
+        case 1: PWM1H = HIBYTE(ticks); PWM1L = LOBYTE(ticks); break;
+        case 2: PWM2H = HIBYTE(ticks); PWM2L = LOBYTE(ticks); break;
+        case 3: PWM3H = HIBYTE(ticks); PWM3L = LOBYTE(ticks); break;
+        case 4: set_SFRS_SFRPAGE; PWM4H = HIBYTE(ticks); PWM4L = LOBYTE(ticks); clr_SFRS_SFRPAGE; break;
+        default: set_SFRS_SFRPAGE; PWM5H = HIBYTE(ticks); PWM5L = LOBYTE(ticks); clr_SFRS_SFRPAGE; break;
+    }
+
+    g_Pwm0CtrlManager.duty_ticks[ch] = ticks;
+}
+
+void PWM0_Ctrl_SetTicks(unsigned char ch, unsigned int ticks)
+{
+    if (ch >= PWM0_CTRL_CHANNELS)
+    {
+        return;
+    }
+
+    pwm0_ctrl_write_ticks(ch, ticks);
+
+    /* raw ticks from outside : duty_x10000 follows at the next frequency change */
+    g_Pwm0CtrlManager.raw_mask |= (unsigned char)(1U << ch);
+}
+
+void PWM0_Ctrl_SetDuty10000(unsigned char ch, unsigned int duty)
+{
+    if (ch >= PWM0_CTRL_CHANNELS)
+    {
+        return;
+    }
+    if (duty > DUTY_RESOLUTION_HI)
+    {
+        duty = DUTY_RESOLUTION_HI;
+    }
+
+    /* command -> output duty (DETECT_DUTY_CURVE), then multiplies only : no back-fill divide */
+    duty = Duty_Curve(duty);
+    pwm0_ctrl_write_ticks(ch, Duty_Scale(duty, g_Pwm0CtrlManager.period, g_Pwm0CtrlManager.recip));
+    g_Pwm0CtrlManager.duty_x10000[ch] = duty;
+    g_Pwm0CtrlManager.raw_mask &= (unsigned char)~(1U << ch);
+    set_PWMCON0_LOAD;
+}
+
+/* RAM only, ch checked by the caller */
+static void pwm0_ctrl_stage_ticks(unsigned char ch, unsigned int ticks)
+{
+    g_Pwm0CtrlManager.stage_ticks[ch] = ticks;
+    g_Pwm0CtrlManager.dirty_mask |= (unsigned char)(1U << ch);
+}
+
+void PWM0_Ctrl_StageTicks(unsigned char ch, unsigned int ticks)
+{
+    if (ch >= PWM0_CTRL_CHANNELS)
+    {
+        return;
+    }
+
+    pwm0_ctrl_stage_ticks(ch, ticks);
+    g_Pwm0CtrlManager.raw_mask |= (unsigned char)(1U << ch);
+}
+
+void PWM0_Ctrl_StageDuty10000(unsigned char ch, unsigned int duty)
+{
+    if (ch >= PWM0_CTRL_CHANNELS)
+    {
+        return;
+    }
+    if (duty > DUTY_RESOLUTION_HI)
+    {
+        duty = DUTY_RESOLUTION_HI;
+    }
+
+    duty = Duty_Curve(duty);
+    pwm0_ctrl_stage_ticks(ch, Duty_Scale(duty, g_Pwm0CtrlManager.period, g_Pwm0CtrlManager.recip));
+    g_Pwm0CtrlManager.duty_x10000[ch] = duty;
+    g_Pwm0CtrlManager.raw_mask &= (unsigned char)~(1U << ch);
+}
+
+unsigned char PWM0_Ctrl_Commit(void)
+{
+    unsigned char dirty;
+
+    dirty = g_Pwm0CtrlManager.dirty_mask;
+    if (dirty == 0U)
+    {
+        return 1U;
+    }
+
+    /* registers written now would join the pending load and split the batch over two periods,
+       PWM_Play sets LOAD from its ISR at any point between the writes */
+    if ((LOAD != 0) || (g_Pwm0CtrlManager.play_lock != 0U))
+    {
+        return 0U;
+    }
+
+    /* page 0 channels first ... */
+    if (dirty & 0x01U) { PWM0H = HIBYTE(g_Pwm0CtrlManager.stage_ticks[0]); PWM0L = LOBYTE(g_Pwm0CtrlManager.stage_ticks[0]); }
+    if (dirty & 0x02U) { PWM1H = HIBYTE(g_Pwm0CtrlManager.stage_ticks[1]); PWM1L = LOBYTE(g_Pwm0CtrlManager.stage_ticks[1]); }
+    if (dirty & 0x04U) { PWM2H = HIBYTE(g_Pwm0CtrlManager.stage_ticks[2]); PWM2L = LOBYTE(g_Pwm0CtrlManager.stage_ticks[2]); }
+    if (dirty & 0x08U) { PWM3H = HIBYTE(g_Pwm0CtrlManager.stage_ticks[3]); PWM3L = LOBYTE(g_Pwm0CtrlManager.stage_ticks[3]); }
+
+    /* ... then one page switch for PWM4 / PWM5 */
+    if (dirty & 0x30U)
+    {
+        set_SFRS_SFRPAGE;
+        if (dirty & 0x10U) { PWM4H = HIBYTE(g_Pwm0CtrlManager.stage_ticks[4]); PWM4L = LOBYTE(g_Pwm0CtrlManager.stage_ticks[4]); }
+        if (dirty & 0x20U) { PWM5H = HIBYTE(g_Pwm0CtrlManager.stage_ticks[5]); PWM5L = LOBYTE(g_Pwm0CtrlManager.stage_ticks[5]); }
+        clr_SFRS_SFRPAGE;
+    }
+
+    set_PWMCON0_LOAD;
+
+    if (dirty & 0x01U) { g_Pwm0CtrlManager.duty_ticks[0] = g_Pwm0CtrlManager.stage_ticks[0]; }
+    if (dirty & 0x02U) { g_Pwm0CtrlManager.duty_ticks[1] = g_Pwm0CtrlManager.stage_ticks[1]; }
+    if (dirty & 0x04U) { g_Pwm0CtrlManager.duty_ticks[2] = g_Pwm0CtrlManager.stage_ticks[2]; }
+    if (dirty & 0x08U) { g_Pwm0CtrlManager.duty_ticks[3] = g_Pwm0CtrlManager.stage_ticks[3]; }
+    if (dirty & 0x10U) { g_Pwm0CtrlManager.duty_ticks[4] = g_Pwm0CtrlManager.stage_ticks[4]; }
+    if (dirty & 0x20U) { g_Pwm0CtrlManager.duty_ticks[5] = g_Pwm0CtrlManager.stage_ticks[5]; }
+    g_Pwm0CtrlManager.dirty_mask = 0U;
+
+    return 1U;
+}
+
+unsigned char PWM0_Ctrl_IsLoaded(void)
+{
+    return (LOAD == 0) ? 1U : 0U;
+}
+
+/* new divider / period with every duty rescaled, one LOAD ; 0 while a LOAD is pending */
+static unsigned char pwm0_ctrl_apply(unsigned char div_code, unsigned int period, unsigned long recip)
+{
+    unsigned char i;
+    unsigned char change_div;
+    unsigned int ticks;
+
+    /* the whole set goes out in one LOAD, same rule as PWM0_Ctrl_Commit() ;
+       the previous divider switch has to be done first */
+    if ((LOAD != 0) || (g_Pwm0CtrlManager.play_lock != 0U) || (g_Pwm0CtrlManager.div_pending != 0U))
+    {
+        return 0U;
+    }
+
+    change_div = (div_code != g_Pwm0CtrlManager.div_code) ? 1U : 0U;
+
+    /* channels set in ticks : their duty on the old period, the only divides of the update path */
+    for (i = 0U; i < PWM0_CTRL_CHANNELS; i++)
+    {
+        if (g_Pwm0CtrlManager.raw_mask & (unsigned char)(1U << i))
+        {
+            ticks = (g_Pwm0CtrlManager.dirty_mask & (unsigned char)(1U << i)) ?
+                    g_Pwm0CtrlManager.stage_ticks[i] : g_Pwm0CtrlManager.duty_ticks[i];
+            g_Pwm0CtrlManager.duty_x10000[i] = (unsigned int)UDIV_ROUND_NEAREST((unsigned long)ticks * DUTY_RESOLUTION_HI,
+                                                                                g_Pwm0CtrlManager.period);
+        }
+    }
+    g_Pwm0CtrlManager.raw_mask = 0U;
+
+    g_Pwm0CtrlManager.period   = period;
+    g_Pwm0CtrlManager.recip    = recip;
+    g_Pwm0CtrlManager.div_code = div_code;
+
+    /* same duty on the new period : multiplies only (Duty_Scale with the new reciprocal) */
+    for (i = 0U; i < PWM0_CTRL_CHANNELS; i++)
+    {
+        g_Pwm0CtrlManager.stage_ticks[i] = Duty_Scale(g_Pwm0CtrlManager.duty_x10000[i], period, recip);
+    }
+    g_Pwm0CtrlManager.dirty_mask = 0x3FU;
+
+    /* period buffered until LOAD like the duties ; PWMCON1 would apply at once (the period in
+       progress on the new clock), PWM_ISR() writes it at the period end that takes the LOAD */
+    PWMPH = HIBYTE(period - 1u);
+    PWMPL = LOBYTE(period - 1u);
+
+    if (change_div != 0U)
+    {
+        PWM0_PERIOD_END_INT;
+        SET_INT_PWM_LEVEL1;             //same as PWM_Play : below Timer1 / edge ISR
+        clr_PWMCON0_PWMF;               //before LOAD : the ISR then sees every period end after it
+    }
+
+    (void)PWM0_Ctrl_Commit();           //cannot refuse : LOAD and play_lock checked above
+
+    if (change_div != 0U)
+    {
+        g_Pwm0CtrlManager.div_pending = 1U;
+        ENABLE_PWM0_INTERRUPT;
+    }
+
+    return 1U;
+}
+
+unsigned char PWM0_Ctrl_SetFreq(unsigned long freq_hz)
+{
+    unsigned char i;
+    unsigned char div_code;
+    unsigned int period;
+    unsigned long recip;
+    unsigned long p;
+
+    if (freq_hz < PWM_FREQ_MIN_HZ)
+    {
+        return 0U;
+    }
+
+    /* common frequencies : all constants, no division */
+    for (i = 0U; i < PWM0_FREQ_TABLE_SIZE; i++)
+    {
+        if (pwm0_freq_table[i].freq_hz == freq_hz)
+        {
+            break;
+        }
+    }
+
+    if (i < PWM0_FREQ_TABLE_SIZE)
+    {
+        div_code = pwm0_freq_table[i].div_code;
+        period   = pwm0_freq_table[i].period;
+        recip    = pwm0_freq_table[i].recip;
+    }
+    else
+    {
+        /* smallest divider whose period fits 16 bit */
+        p = 0UL;
+        for (div_code = 0U; div_code < 8U; div_code++)
+        {
+            p = UDIV_ROUND_NEAREST(PWM_FSYS_HZ >> div_code, freq_hz);
+            if (p <= PWM_PERIOD_MAX)
+            {
+                break;
+            }
+        }
+        if ((div_code >= 8U) || (p < PWM_PERIOD_MIN))
+        {
+            return 0U;
+        }
+        period = (unsigned int)p;
+        recip  = DUTY_RECIP_Q16(period);
+    }
+
+    if (pwm0_ctrl_apply(div_code, period, recip) == 0U)
+    {
+        return 0U;
+    }
+    g_Pwm0CtrlManager.freq_hz = freq_hz;
+
+    return 1U;
+}
+
+void PWM0_Ctrl_SetComplementary(unsigned char pairs, unsigned int dt_count, unsigned char center)
+{
+    unsigned char pdten;
+    unsigned char ch;
+
+    pairs &= PWM0_PAIR_ALL;
+    if (dt_count > PWM_DEADTIME_COUNT_MAX)
+    {
+        dt_count = PWM_DEADTIME_COUNT_MAX;
+    }
+
+    PWM0_COMPLEMENTARY_MODE;
+    if (center != 0U)
+    {
+        PWM0_CENTER_TYPE;
+    }
+    else
+    {
+        PWM0_EDGE_TYPE;
+    }
+
+    /* PDTEN[4] = PDTCNT bit 8, PDTEN[2:0] = pair enables */
+    pdten = (unsigned char)(((dt_count & 0x0100U) >> 4) | pairs);
+    BIT_TMP = EA;
+    EA = 0;
+    TA = 0xAA;
+    TA = 0x55;
+    PDTEN = pdten;
+    TA = 0xAA;
+    TA = 0x55;
+    PDTCNT = (unsigned char)(dt_count & 0x00FFU);
+    EA = BIT_TMP;
+
+    for (ch = 0U; ch < PWM0_CTRL_CHANNELS; ch += 2U)
+    {
+        if (pairs & (unsigned char)(1U << (ch >> 1)))
+        {
+            PWM0_Ctrl_Enable(ch);
+            PWM0_Ctrl_Enable(ch + 1U);
+        }
+    }
+}
+
+unsigned int PWM0_Ctrl_DeadTimeCount(unsigned long ns, unsigned long fsys_hz)
+{
+    unsigned long khz;
+    unsigned long count;
+
+    /* ns * kHz / 1e6, both rounded up : never shorter than asked (16.6 MHz is not 16 MHz) */
+    khz = (fsys_hz + 999UL) / 1000UL;
+    if ((khz == 0UL) || (ns > (0xFFFFFFFFUL - 999999UL) / khz))
+    {
+        return PWM_DEADTIME_INVALID;
+    }
+    count = ((ns * khz) + 999999UL) / 1000000UL;
+    if ((count == 0UL) || (count > (PWM_DEADTIME_COUNT_MAX + 1UL)))
+    {
+        return PWM_DEADTIME_INVALID;
+    }
+
+    return (unsigned int)(count - 1UL);
+}
+
+unsigned char PWM0_Ctrl_SetSync(unsigned char on)
+{
+    /* both retune the period : one owner at a time */
+    if ((on != 0U) && (g_Pwm0CtrlManager.play_lock != 0U))
+    {
+        return 0U;
+    }
+
+    g_Pwm0CtrlManager.sync_locked = 0U;
+    g_Pwm0CtrlManager.sync_gates  = g_FreqMeterManager.gates - 1U;   /* take the last gate at once */
+    g_Pwm0CtrlManager.sync_mode   = (on != 0U) ? 1U : 0U;
+
+    return 1U;
+}
+
+void PWM0_Ctrl_SyncProcess(void)
+{
+    unsigned int gates;
+    unsigned long f;
+    unsigned long p;
+    unsigned long period;
+    unsigned long diff;
+    unsigned char div_code;
+    unsigned char locked;
+
+    if (g_Pwm0CtrlManager.sync_mode == 0U)
+    {
+        return;
+    }
+
+    gates = g_FreqMeterManager.gates;
+    if (gates == g_Pwm0CtrlManager.sync_gates)
+    {
+        return;
+    }
+
+    f = FreqMeter_GetFreq_x100();
+    if (f < (PWM_FREQ_MIN_HZ * 100UL))
+    {
+        g_Pwm0CtrlManager.sync_locked = 0U;
+        g_Pwm0CtrlManager.sync_gates  = gates;
+        return;
+    }
+
+    /* period = PWM clock / f, f in 0.01 Hz : (Fsys >> div) * 100 stays inside 32 bit */
+    p = 0UL;
+    for (div_code = 0U; div_code < 8U; div_code++)
+    {
+        p = (((PWM_FSYS_HZ >> div_code) * 100UL) + (f / 2UL)) / f;
+        if (p <= PWM_PERIOD_MAX)
+        {
+            break;
+        }
+    }
+    if ((div_code >= 8U) || (p < PWM_PERIOD_MIN))
+    {
+        g_Pwm0CtrlManager.sync_locked = 0U;
+        g_Pwm0CtrlManager.sync_gates  = gates;
+        return;
+    }
+
+    /* locked : this gate confirms the period already running (same clock, within tolerance) */
+    period = g_Pwm0CtrlManager.period;
+    diff   = (p > period) ? (p - period) : (period - p);
+    locked = ((div_code == g_Pwm0CtrlManager.div_code) &&
+              ((diff * 10000UL) <= ((unsigned long)period * PWM_SYNC_LOCK_X10000))) ? 1U : 0U;
+
+    if ((div_code != g_Pwm0CtrlManager.div_code) || ((unsigned int)p != period))
+    {
+        if (locked == 0U)
+        {
+            g_Pwm0CtrlManager.sync_locked = 0U;     /* no phase reset while the period moves */
+        }
+        if (pwm0_ctrl_apply(div_code, (unsigned int)p, DUTY_RECIP_Q16(p)) == 0U)
+        {
+            return;     /* LOAD pending : same gate next loop */
+        }
+        g_Pwm0CtrlManager.freq_hz = (f + 50UL) / 100UL;
+    }
+
+    g_Pwm0CtrlManager.sync_locked = locked;
+    g_Pwm0CtrlManager.sync_gates  = gates;
+}
+
+/*
+	ch : channel index
+	frequency : target frequency (unit:Hz) , ex:100 , 1000
+	duty : percent
+	resolution : 100 ~ 10000
+
+	ex1 :
+	target duty = 95% => duty = 95,resolution = 100
+	target duty = 87.5% => duty = 875,resolution = 1000
+	target duty = 97.75% => duty = 9775,resolution = 10000
+
+	every resolution is brought to 0..DUTY_RESOLUTION_HI (10000) first (UDIV_ROUND_NEAREST, once at init),
+	then PWM0_Ctrl_SetDuty10000() : DETECT_DUTY_CURVE and the precomputed reciprocal (multiply only),
+	same output as the detect path for the same duty
+*/
+void pwm_channel_Init(unsigned char ch,unsigned int duty,unsigned int resolution)
+{
+    PWM0_Ctrl_Init();
+    PWM0_Ctrl_Enable(ch);
+
+    if (resolution == 0U)
+    {
+        return;
+    }
+    if (duty > resolution)
+    {
+        duty = resolution;
+    }
+    if (resolution != DUTY_RESOLUTION_HI)
+    {
+        duty = (unsigned int)UDIV_ROUND_NEAREST((unsigned long)duty * DUTY_RESOLUTION_HI, (unsigned long)resolution);
+    }
+    PWM0_Ctrl_SetDuty10000(ch, duty);   //LOAD set there
+
+    set_PWMCON0_PWMRUN;
+}
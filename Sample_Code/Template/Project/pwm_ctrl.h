@@ -0,0 +1,195 @@
+#ifndef __PWM_CTRL_H__
+#define __PWM_CTRL_H__
+
+/*_____ I N C L U D E S ____________________________________________________*/
+
+/*_____ D E C L A R A T I O N S ____________________________________________*/
+
+/*_____ D E F I N I T I O N S ______________________________________________*/
+
+#define PWM0_CTRL_CHANNELS          (6U)
+
+/*
+	100 Hz
+	24MHz / 128 = 187,500 Hz;
+	187,500 / 100 Hz = 1,875 ticks → PERIOD=1875-1
+
+
+	60 Hz
+	24MHz / 128 = 187,500 Hz;
+	187,500 / 60 Hz = 3125 ticks → PERIOD=3125-1
+
+	50 Hz
+	24MHz / 128 = 187,500 Hz;
+	187,500 / 50 Hz = 3750 ticks → PERIOD=3750-1
+*/
+#define PWM_FSYS_HZ                 (24000000UL)
+#define PWM_BASE_FREQ_HZ            (100u)
+// #define PWM_BASE_FREQ_HZ            (120u)
+#define PWM_DIV_FOR_FREQ            (128u)
+#define PWM_PERIOD_TICKS            ((PWM_FSYS_HZ / PWM_DIV_FOR_FREQ) / PWM_BASE_FREQ_HZ)
+#define PWM_DUTY_RECIP_Q16          (DUTY_RECIP_Q16(PWM_PERIOD_TICKS))   // constant, no runtime division for 0.01 % duty
+#define PWM_DIV_CODE_DEFAULT        (7U)        /* PWMCON1[2:0] : DIV128 */
+
+/* runtime frequency : smallest divider whose period still fits 16 bit = best duty resolution
+   evaluated by the compiler for the table below, searched at run time for other values */
+#define PWM_PERIOD_MAX              (65535UL)
+#define PWM_DIV_CODE_FOR(f)                                                         \
+    (((PWM_FSYS_HZ      ) / (f) <= PWM_PERIOD_MAX) ? 0U :                           \
+     ((PWM_FSYS_HZ >> 1U) / (f) <= PWM_PERIOD_MAX) ? 1U :                           \
+     ((PWM_FSYS_HZ >> 2U) / (f) <= PWM_PERIOD_MAX) ? 2U :                           \
+     ((PWM_FSYS_HZ >> 3U) / (f) <= PWM_PERIOD_MAX) ? 3U :                           \
+     ((PWM_FSYS_HZ >> 4U) / (f) <= PWM_PERIOD_MAX) ? 4U :                           \
+     ((PWM_FSYS_HZ >> 5U) / (f) <= PWM_PERIOD_MAX) ? 5U :                           \
+     ((PWM_FSYS_HZ >> 6U) / (f) <= PWM_PERIOD_MAX) ? 6U : 7U)
+#define PWM_PERIOD_FOR(f)           ((unsigned int)UDIV_ROUND_NEAREST(PWM_FSYS_HZ >> PWM_DIV_CODE_FOR(f), (f)))
+#define PWM_FREQ_ENTRY(f)           {(f), PWM_DIV_CODE_FOR(f), PWM_PERIOD_FOR(f), DUTY_RECIP_Q16(PWM_PERIOD_FOR(f))}
+
+/* PWM clock DIV128 : lowest frequency with a 16 bit period */
+#define PWM_FREQ_MIN_HZ             ((PWM_FSYS_HZ >> 7U) / PWM_PERIOD_MAX + 1UL)
+#define PWM_PERIOD_MIN              (100U)      /* keeps 1 % duty steps at the top end */
+
+/* complementary pairs : PDTEN enable bits, PWM1 / PWM3 / PWM5 mirror PWM0 / PWM2 / PWM4 */
+#define PWM0_PAIR_01                (0x01U)
+#define PWM0_PAIR_23                (0x02U)
+#define PWM0_PAIR_45                (0x04U)
+#define PWM0_PAIR_ALL               (0x07U)
+
+/* dead time = (PDTCNT + 1) / Fsys, 9 bit count : 41.7 ns .. 21.3 us at 24 MHz
+   count = ceil(ns * Fsys / 1e9) - 1, Fsys rounded up to kHz : never shorter than asked */
+#define PWM_DEADTIME_COUNT_MAX      (0x1FFUL)
+#define PWM_FSYS_KHZ                ((PWM_FSYS_HZ + 999UL) / 1000UL)
+#define PWM_DEADTIME_COUNT(ns)      (((((unsigned long)(ns)) * PWM_FSYS_KHZ) + 999999UL) / 1000000UL - 1UL)
+#define PWM_DEADTIME_INVALID        (0xFFFFU)
+
+#define PWM0_DEADTIME_NS_DEFAULT    (500UL)
+
+/* sync : period locked once a new gate asks for the same divider and a period within this
+   of the running one (0.01 % units) */
+#define PWM_SYNC_LOCK_X10000        (10UL)
+
+/* compile-time check : negative array size when cond is false */
+#define PWM_STATIC_ASSERT(tag, cond)    typedef char pwm_static_assert_##tag[(cond) ? 1 : -1]
+
+/* compile-time checked complementary setup, ns must be a constant */
+#define PWM0_CTRL_COMPLEMENTARY_NS(pairs, ns, center)                               \
+    do {                                                                            \
+        PWM_STATIC_ASSERT(deadtime_range, ((ns) > 0UL) &&                           \
+                          (PWM_DEADTIME_COUNT(ns) <= PWM_DEADTIME_COUNT_MAX));      \
+        PWM0_Ctrl_SetComplementary((pairs), (unsigned int)PWM_DEADTIME_COUNT(ns), (center)); \
+    } while (0)
+
+/* compile-time divider / period / reciprocal for common frequencies, CODE space */
+typedef struct _pwm0_freq_entry_t
+{
+    unsigned long freq_hz;
+    unsigned char div_code;         /* PWMCON1[2:0] : DIV 1 << div_code */
+    unsigned int period;            /* PWMP + 1 */
+    unsigned long recip;            /* DUTY_RECIP_Q16(period) */
+}PWM0_FREQ_ENTRY_T;
+
+/* one PWM0 channel : output pin and its PIOCON enable bit, CODE space */
+typedef struct _pwm0_ctrl_desc_t
+{
+    unsigned char pio_page;         /* 0: PIOCON0, 1: PIOCON1 (SFR page 1) */
+    unsigned char pio_mask;         /* output enable bit in PIOCONx */
+    unsigned char port;             /* 0: P0, 1: P1 */
+    unsigned char pin_mask;         /* pin bit, set to push-pull on enable */
+}PWM0_CTRL_DESC_T;
+
+typedef struct _pwm0_ctrl_manager_t
+{
+    unsigned int period;            /* PWM0 period in PWM clocks (PWMP + 1) */
+    unsigned long recip;            /* DUTY_RECIP_Q16(period) */
+    unsigned char div_code;         /* PWMCON1[2:0] */
+    unsigned long freq_hz;          /* frequency asked by PWM0_Ctrl_SetFreq() */
+    unsigned int duty_x10000[PWM0_CTRL_CHANNELS];  /* output duty (after the curve) kept across frequency changes */
+    unsigned char sync_mode;        /* 1: period follows the input, counter cleared at each window */
+    unsigned int sync_gates;        /* freq meter gate the period was last set from */
+    unsigned char sync_locked;      /* 1: two gates agreed on the period, phase sync (CLRPWM) allowed */
+    unsigned char enable_mask;      /* bit n : channel n routed to its pin */
+    unsigned int duty_ticks[PWM0_CTRL_CHANNELS];   /* last value written to PWMnH:PWMnL */
+    unsigned int stage_ticks[PWM0_CTRL_CHANNELS];  /* batch : values waiting for PWM0_Ctrl_Commit() */
+    unsigned char dirty_mask;       /* batch : bit n = stage_ticks[n] not written yet */
+    unsigned char play_lock;        /* 1: PWM_Play ISR sets LOAD every period, batch / frequency refused */
+    unsigned char div_pending;      /* 1: div_code goes to PWMCON1 at the next period end (PWM_ISR) */
+    unsigned char raw_mask;         /* bit n : set in ticks, duty_x10000[n] derived only at the next frequency change */
+}PWM0_CTRL_MANAGER_T;
+
+extern volatile PWM0_CTRL_MANAGER_T g_Pwm0CtrlManager;
+
+/*_____ M A C R O S ________________________________________________________*/
+
+#define UDIV_ROUND_NEAREST(a,b)     ( ((unsigned long)(a) + ((unsigned long)(b)/2u)) / (unsigned long)(b) )
+
+/* Timer1 ISR, confirmed real window : restart the PWM0 counter so every PWM period starts a
+   fixed delay (confirm time) after the input edge ; no CPU cost per PWM period
+   only once the period is locked : during acquisition the counter would be cut mid-period */
+#define PWM0_SYNC_EDGE()                                                            \
+    do {                                                                            \
+        if (g_Pwm0CtrlManager.sync_locked != 0U) { set_PWMCON0_CLRPWM; }            \
+    } while (0)
+
+/*_____ F U N C T I O N S __________________________________________________*/
+
+/* independent mode, current divider / period (DIV128, PWM_PERIOD_TICKS after reset) ;
+   channels stay off until PWM0_Ctrl_Enable() */
+void PWM0_Ctrl_Init(void);
+
+/* route channel ch (0..5) to its pin from the descriptor table, pin push-pull */
+void PWM0_Ctrl_Enable(unsigned char ch);
+void PWM0_Ctrl_Disable(unsigned char ch);
+
+/* write PWMnH:PWMnL (PWM clocks), takes effect at the next LOAD ; no divide here, the duty
+   kept for a frequency change is worked out from the ticks by PWM0_Ctrl_SetFreq() / sync */
+void PWM0_Ctrl_SetTicks(unsigned char ch, unsigned int ticks);
+
+/* duty command 0..DUTY_RESOLUTION_HI (0.01 %) -> DETECT_DUTY_CURVE -> ticks with the precomputed
+   reciprocal, then LOAD ; duty_x10000 keeps the output duty (after the curve) */
+void PWM0_Ctrl_SetDuty10000(unsigned char ch, unsigned int duty);
+
+/* batch : stage any subset of channels (RAM only, no SFR access), duties through the curve ... */
+void PWM0_Ctrl_StageTicks(unsigned char ch, unsigned int ticks);
+void PWM0_Ctrl_StageDuty10000(unsigned char ch, unsigned int duty);
+
+/* ... then write them all and set LOAD once : every channel switches at the same period end
+   returns 0 (nothing written, stage kept) while the previous LOAD is still pending or
+   PWM_Play is running (its ISR would split the batch) */
+unsigned char PWM0_Ctrl_Commit(void);
+
+/* 1: last LOAD taken by hardware (LOAD bit cleared at the period end) */
+unsigned char PWM0_Ctrl_IsLoaded(void);
+
+/* switch PWM0 to freq_hz : divider / period from the table or searched, every channel duty
+   rescaled and loaded with the new period in one LOAD ; returns 0 when out of range, a
+   LOAD is still pending or PWM_Play is running (nothing changed) ; stop PWM_Play first,
+   restart it on the new period
+   a divider change is taken by the PWM period end interrupt together with the new period :
+   the counter restarts there, that one period is stretched by the ISR latency (us) instead
+   of running on the wrong clock */
+unsigned char PWM0_Ctrl_SetFreq(unsigned long freq_hz);
+
+/* complementary mode : pairs (PWM0_PAIR_xx) with dead time count (PWM_DEADTIME_COUNT()),
+   both pins of each pair enabled ; center != 0 : center aligned, the counter runs up and down
+   so the output frequency halves (Fpwm = PWM clock / (2 * PWMP)) for the same period value */
+void PWM0_Ctrl_SetComplementary(unsigned char pairs, unsigned int dt_count, unsigned char center);
+
+/* dead time in ns at fsys_hz -> PDTCNT count, PWM_DEADTIME_INVALID when 0 or above 9 bit */
+unsigned int PWM0_Ctrl_DeadTimeCount(unsigned long ns, unsigned long fsys_hz);
+
+/* synchronized mode : PWM0 period locked to the input frequency from the freq meter, counter
+   cleared at each confirmed window ; 0 leaves the last period running free
+   returns 0 (mode unchanged) when asked on while PWM_Play is running */
+unsigned char PWM0_Ctrl_SetSync(unsigned char on);
+
+/* main loop : new freq meter gate -> divider / period search (0.01 Hz input), rescale, LOAD */
+void PWM0_Ctrl_SyncProcess(void);
+
+/*
+	ch : channel index (0..5)
+	duty : percent
+	resolution : 100 ~ 10000, normalized to 0..10000 then PWM0_Ctrl_SetDuty10000() (curve applied)
+*/
+void pwm_channel_Init(unsigned char ch,unsigned int duty,unsigned int resolution);
+
+#endif //__PWM_CTRL_H__
@@ -0,0 +1,252 @@
+/*_____ I N C L U D E S ____________________________________________________*/
+#include <stdio.h>
+
+#include "numicro_8051.h"
+
+#include "freq_meter.h"
+#include "pwm_ctrl.h"
+#include "pwm_play.h"
+
+/*_____ D E C L A R A T I O N S ____________________________________________*/
+
+/*_____ D E F I N I T I O N S ______________________________________________*/
+volatile PWM_PLAY_MANAGER_T g_PwmPlayManager =
+{
+    {0, 0},           /* table */
+    {0U, 0U},         /* idx_shift */
+    0U,               /* slot */
+    0U,               /* swap_req */
+
+    0U,               /* phase */
+    0U,               /* step */
+    0U,               /* ch_mask */
+    0U,               /* period_hi */
+    0U,               /* period_lo */
+    1U,               /* loop */
+    0U,               /* active */
+    0U,               /* done */
+
+    0U,               /* samples */
+    0U,               /* cost_last */
+    0U                /* cost_max */
+};
+
+/* 127.5 + 127.5 * sin(2 pi i / 64) */
+const unsigned char code g_PwmPlaySine64[1U << PWM_PLAY_SINE_SHIFT] =
+{
+    128U, 140U, 152U, 165U, 176U, 188U, 198U, 208U, 218U, 226U, 234U, 240U, 245U, 250U, 253U, 254U,
+    255U, 254U, 253U, 250U, 245U, 240U, 234U, 226U, 218U, 208U, 198U, 188U, 176U, 165U, 152U, 140U,
+    128U, 115U, 103U,  90U,  79U,  67U,  57U,  47U,  37U,  29U,  21U,  15U,  10U,   5U,   2U,   1U,
+      0U,   1U,   2U,   5U,  10U,  15U,  21U,  29U,  37U,  47U,  57U,  67U,  79U,  90U, 103U, 115U
+};
+
+/*_____ M A C R O S ________________________________________________________*/
+
+#if defined (ENABLE_PWM_PLAY_PROFILE)
+#define PWM_PLAY_PROFILE_BEGIN                      (P30 = 1)
+#define PWM_PLAY_PROFILE_END                        (P30 = 0)
+#else
+#define PWM_PLAY_PROFILE_BEGIN
+#define PWM_PLAY_PROFILE_END
+#endif
+
+/* Timer2 runs free only in the freq meter software mode : entry / exit stamps give the cost */
+#if defined (ENABLE_FREQ_METER) && (FREQ_METER_SOURCE == FREQ_METER_SRC_SOFTWARE)
+#define PWM_PLAY_COST_STAMP(t)                      ((t) = TL2)
+#define PWM_PLAY_COST_END(t)                                                        \
+    do {                                                                            \
+        unsigned char _c = (unsigned char)(TL2 - (t));                              \
+        g_PwmPlayManager.cost_last = _c;                                            \
+        if (_c > g_PwmPlayManager.cost_max) { g_PwmPlayManager.cost_max = _c; }     \
+    } while (0)
+#else
+#define PWM_PLAY_COST_STAMP(t)                      ((t) = 0U)
+#define PWM_PLAY_COST_END(t)                        ((void)(t))
+#endif
+
+/*_____ F U N C T I O N S __________________________________________________*/
+
+#if defined (ENABLE_PWM_PLAY)
+/* PWM period end : one sample per period, called from PWM_ISR() (pwm_ctrl.c) only */
+void PWM_Play_irq(void)
+{
+    unsigned char t0;
+    unsigned char s;
+    unsigned char mask;
+    unsigned int ticks;
+    unsigned int step;
+
+    PWM_PLAY_PROFILE_BEGIN;
+    PWM_PLAY_COST_STAMP(t0);
+
+    if (g_PwmPlayManager.active != 0U)
+    {
+        /* sample at the current phase first : the first period after PWM_Play_Start() plays table[0] */
+        s = g_PwmPlayManager.table[g_PwmPlayManager.slot]
+                [(unsigned char)(g_PwmPlayManager.phase >> 8) >> g_PwmPlayManager.idx_shift[g_PwmPlayManager.slot]];
+
+        /* s * period / 256 as two 8x8 multiplies (MUL AB), no 16x16 library call */
+        ticks = (unsigned int)((unsigned char)s * g_PwmPlayManager.period_hi) +
+                (((unsigned int)((unsigned char)s * g_PwmPlayManager.period_lo)) >> 8);
+
+        mask = g_PwmPlayManager.ch_mask;
+        if (mask & 0x01U) { PWM0H = HIBYTE(ticks); PWM0L = LOBYTE(ticks); }
+        if (mask & 0x02U) { PWM1H = HIBYTE(ticks); PWM1L = LOBYTE(ticks); }
+        if (mask & 0x04U) { PWM2H = HIBYTE(ticks); PWM2L = LOBYTE(ticks); }
+        if (mask & 0x08U) { PWM3H = HIBYTE(ticks); PWM3L = LOBYTE(ticks); }
+        if (mask & 0x30U)
+        {
+            SFRS = 1;
+            if (mask & 0x10U) { PWM4H = HIBYTE(ticks); PWM4L = LOBYTE(ticks); }
+            if (mask & 0x20U) { PWM5H = HIBYTE(ticks); PWM5L = LOBYTE(ticks); }
+            SFRS = 0;
+        }
+        set_PWMCON0_LOAD;               //taken at the next period end
+
+        g_PwmPlayManager.samples++;
+
+        /* then advance for the next period */
+        step = g_PwmPlayManager.step;
+        g_PwmPlayManager.phase += step;
+        if (g_PwmPlayManager.phase < step)
+        {
+            /* table wrap : the only point where a new table joins without a jump */
+            if (g_PwmPlayManager.swap_req != 0U)
+            {
+                g_PwmPlayManager.slot    ^= 1U;
+                g_PwmPlayManager.swap_req = 0U;
+            }
+            if (g_PwmPlayManager.loop == 0U)
+            {
+                /* one pass played, the last sample holds */
+                g_PwmPlayManager.active = 0U;
+                g_PwmPlayManager.done   = 1U;
+                g_Pwm0CtrlManager.play_lock = 0U;   //no more LOAD from here
+            }
+        }
+    }
+
+    PWM_PLAY_COST_END(t0);
+    PWM_PLAY_PROFILE_END;
+}
+#endif
+
+unsigned char PWM_Play_Load(const unsigned char *table, unsigned char len_shift)
+{
+    unsigned char next;
+
+    if ((len_shift == 0U) || (len_shift > 8U))
+    {
+        return 0U;
+    }
+    if (g_PwmPlayManager.swap_req != 0U)
+    {
+        return 0U;
+    }
+
+    next = g_PwmPlayManager.slot ^ 1U;
+    g_PwmPlayManager.table[next]     = table;
+    g_PwmPlayManager.idx_shift[next] = 8U - len_shift;
+
+    if (g_PwmPlayManager.active == 0U)
+    {
+        g_PwmPlayManager.slot = next;   /* ISR idle : no wrap to wait for */
+    }
+    else
+    {
+        g_PwmPlayManager.swap_req = 1U;
+    }
+
+    return 1U;
+}
+
+unsigned char PWM_Play_Start(unsigned char ch_mask, unsigned int step, unsigned char loop)
+{
+    unsigned int period;
+
+    /* sync retunes the period under the ISR, a staged batch would be split by its LOADs ;
+       refused before touching anything : a divider switch in flight still needs PWM_ISR */
+    if ((g_Pwm0CtrlManager.sync_mode != 0U) || (g_Pwm0CtrlManager.dirty_mask != 0U) ||
+        (g_Pwm0CtrlManager.div_pending != 0U))
+    {
+        return 0U;
+    }
+
+    PWM_Play_Stop();
+
+    if (g_PwmPlayManager.table[g_PwmPlayManager.slot] == 0)
+    {
+        g_PwmPlayManager.table[g_PwmPlayManager.slot]     = g_PwmPlaySine64;
+        g_PwmPlayManager.idx_shift[g_PwmPlayManager.slot] = 8U - PWM_PLAY_SINE_SHIFT;
+    }
+
+    period = g_Pwm0CtrlManager.period;
+    g_PwmPlayManager.period_hi = HIBYTE(period);
+    g_PwmPlayManager.period_lo = LOBYTE(period);
+    g_PwmPlayManager.ch_mask   = ch_mask & 0x3FU;
+    g_PwmPlayManager.step      = step;
+    g_PwmPlayManager.loop      = (loop != 0U) ? 1U : 0U;
+    g_PwmPlayManager.phase     = 0U;            /* first sample is table[0] */
+    g_PwmPlayManager.done      = 0U;
+    g_PwmPlayManager.cost_max  = 0U;
+
+    PWM0_PERIOD_END_INT;
+    clr_PWMCON0_PWMF;
+    SET_INT_PWM_LEVEL1;                 //below Timer1 / edge ISR : detect timing first
+    g_PwmPlayManager.active = 1U;
+    g_Pwm0CtrlManager.play_lock = 1U;
+    ENABLE_PWM0_INTERRUPT;
+
+    return 1U;
+}
+
+void PWM_Play_Stop(void)
+{
+    DISABLE_PWM0_INTERRUPT;
+    g_PwmPlayManager.active   = 0U;
+    g_PwmPlayManager.swap_req = 0U;
+    g_Pwm0CtrlManager.play_lock = 0U;   //a LOAD set by the last sample is still seen by Commit
+
+    /* divider switch not taken yet : PWM_ISR finishes it, then masks itself (play_lock is 0) */
+    if (g_Pwm0CtrlManager.div_pending != 0U)
+    {
+        ENABLE_PWM0_INTERRUPT;
+    }
+}
+
+void PWM_Play_SetStep(unsigned int step)
+{
+    /* only the PWM ISR reads it : mask that one, level 3 detect timing keeps running */
+    DISABLE_PWM0_INTERRUPT;
+    g_PwmPlayManager.step = step;
+    if ((g_PwmPlayManager.active != 0U) || (g_Pwm0CtrlManager.div_pending != 0U))
+    {
+        ENABLE_PWM0_INTERRUPT;          //the divider switch also needs PWM_ISR
+    }
+}
+
+unsigned int PWM_Play_StepFromFreq_x100(unsigned int freq_x100)
+{
+    unsigned long half_x100;
+
+    /* step = f * 65536 / f_pwm = (f << 15) / (f_pwm / 2) : f_x100 << 15 < 2^31 for any input,
+       f clamped to f_pwm / 2 (step 32768) so the samples stay meaningful */
+    half_x100 = g_Pwm0CtrlManager.freq_hz * 50UL;
+    if ((unsigned long)freq_x100 > half_x100)
+    {
+        freq_x100 = (unsigned int)half_x100;
+    }
+
+    return (unsigned int)((((unsigned long)freq_x100 << 15) + (half_x100 / 2UL)) / half_x100);
+}
+
+void PWM_Play_log(void)
+{
+    printf("Play: %s mask=0x%02X step=%u samples=%u cost=%u/%u (x16 SYSCLK)\r\n",
+           (g_PwmPlayManager.active != 0U) ? "run" : ((g_PwmPlayManager.done != 0U) ? "done" : "stop"),
+           (unsigned int)g_PwmPlayManager.ch_mask,
+           g_PwmPlayManager.step,
+           g_PwmPlayManager.samples,
+           (unsigned int)g_PwmPlayManager.cost_last,
+           (unsigned int)g_PwmPlayManager.cost_max);
+}
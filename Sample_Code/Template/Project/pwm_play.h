@@ -0,0 +1,72 @@
+#ifndef __PWM_PLAY_H__
+#define __PWM_PLAY_H__
+
+/*_____ I N C L U D E S ____________________________________________________*/
+
+/*_____ D E C L A R A T I O N S ____________________________________________*/
+
+/*_____ D E F I N I T I O N S ______________________________________________*/
+
+/* waveform playback : one 8-bit sample per PWM0 period, from the PWM period end interrupt
+   output frequency = step * PWM0 frequency / 65536, table length 2^n (n = 1..8) */
+#define ENABLE_PWM_PLAY
+
+#define PWM_PLAY_SINE_SHIFT         (6U)        /* built-in table : 64 samples */
+
+typedef struct _pwm_play_manager_t
+{
+    const unsigned char *table[2];  /* [slot] samples, CODE or XDATA (generic pointer) */
+    unsigned char idx_shift[2];     /* [slot] 8 - n : phase high byte -> table index */
+    unsigned char slot;             /* slot the ISR plays */
+    unsigned char swap_req;         /* 1: main loop filled the other slot, ISR swaps at the table wrap */
+
+    unsigned int phase;             /* 16 bit phase accumulator */
+    unsigned int step;              /* phase increment per PWM period */
+    unsigned char ch_mask;          /* bit n : PWM0 channel n follows the samples */
+    unsigned char period_hi;        /* PWM period split for the 8x8 multiplies */
+    unsigned char period_lo;
+    unsigned char loop;             /* 0: stop after one pass, hold the last sample */
+    unsigned char active;           /* 1: ISR writes samples */
+    unsigned char done;             /* 1: one-shot pass finished */
+
+    unsigned int samples;           /* samples written (wraps) */
+    unsigned char cost_last;        /* ISR cost, Timer2 counts (16 SYSCLK), freq meter software mode */
+    unsigned char cost_max;
+}PWM_PLAY_MANAGER_T;
+
+extern volatile PWM_PLAY_MANAGER_T g_PwmPlayManager;
+
+extern const unsigned char code g_PwmPlaySine64[1U << PWM_PLAY_SINE_SHIFT];
+
+/* P3.0 HIGH while the PWM ISR runs : scope the pulse width for the per-sample cost */
+// #define ENABLE_PWM_PLAY_PROFILE
+
+/*_____ M A C R O S ________________________________________________________*/
+
+/*_____ F U N C T I O N S __________________________________________________*/
+
+/* queue a table of 2^len_shift samples into the idle slot ; returns 0 while the previous swap
+   is still pending. The ISR switches at the next table wrap (or at once when stopped) */
+unsigned char PWM_Play_Load(const unsigned char *table, unsigned char len_shift);
+
+/* start the samples on the channels in ch_mask (owned by the ISR until PWM_Play_Stop(),
+   do not stage them with PWM0_Ctrl_*) ; PWM0_Ctrl_Init() done before
+   the ISR sets LOAD every period : PWM0_Ctrl_Commit() / SetFreq() / sync are refused until
+   PWM_Play_Stop() ; returns 0 (not started, a running play left as is) while sync mode, a batch
+   commit or a divider switch is pending */
+unsigned char PWM_Play_Start(unsigned char ch_mask, unsigned int step, unsigned char loop);
+void PWM_Play_Stop(void);
+
+/* phase step, PWM interrupt masked around the 16 bit write (EA untouched) */
+void PWM_Play_SetStep(unsigned int step);
+
+/* output frequency in 0.01 Hz -> step at the current PWM0 frequency (sample rate),
+   clamped to half the sample rate */
+unsigned int PWM_Play_StepFromFreq_x100(unsigned int freq_x100);
+
+void PWM_Play_log(void);
+
+/* PWM period end ISR (pwm_ctrl.c) only */
+void PWM_Play_irq(void);
+
+#endif //__PWM_PLAY_H__
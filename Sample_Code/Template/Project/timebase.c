@@ -0,0 +1,70 @@
+/*_____ I N C L U D E S ____________________________________________________*/
+#include "numicro_8051.h"
+
+#include "detect_pulse.h"
+#include "timebase.h"
+
+/*_____ D E C L A R A T I O N S ____________________________________________*/
+
+/*_____ D E F I N I T I O N S ______________________________________________*/
+volatile TIMEBASE_MANAGER_T g_TimebaseManager =
+{
+    0U,               /* sub_div */
+    0U,               /* div_500ms */
+    0U,               /* half_sec */
+    0U,               /* evt_500ms */
+    0U                /* evt_1000ms */
+};
+
+/*_____ M A C R O S ________________________________________________________*/
+
+/*_____ F U N C T I O N S __________________________________________________*/
+
+void Timer1_ISR(void) interrupt 3        // Vector @  0x1B
+{
+    _push_(SFRS);
+
+    SFRS = 0;              //PWMCON0 (sync CLRPWM) and TL1 are read / written on page 0
+    clr_TCON_TF1;
+    /* TL1 already reloaded from TH1 by hardware : no TH1/TL1 write, no drift */
+
+    // P12 ^= 1;	// for debug period
+
+    output_pulse_irq();
+
+    /* counters instead of % : a few compares per tick */
+    if (++g_TimebaseManager.sub_div >= TIMEBASE_TICKS_PER_MS)
+    {
+        g_TimebaseManager.sub_div = 0U;
+
+        if (++g_TimebaseManager.div_500ms >= 500U)
+        {
+            g_TimebaseManager.div_500ms = 0U;
+            g_TimebaseManager.evt_500ms = 1U;
+
+            g_TimebaseManager.half_sec ^= 1U;
+            if (g_TimebaseManager.half_sec == 0U)
+            {
+                g_TimebaseManager.evt_1000ms = 1U;
+            }
+        }
+    }
+
+    _pop_(SFRS);
+}
+
+void Timebase_Init(void)
+{
+    clr_TCON_TR1;
+    TIMER1_FSYS_DIV12;
+    ENABLE_TIMER1_MODE2;                //8 bit auto-reload
+
+    TH1 = TIMEBASE_RELOAD;
+    TL1 = TIMEBASE_RELOAD;
+    clr_TCON_TF1;
+
+    SET_INT_Timer1_LEVEL3;
+    ENABLE_TIMER1_INTERRUPT;
+    set_TCON_TR1;
+    ENABLE_GLOBAL_INTERRUPT;
+}
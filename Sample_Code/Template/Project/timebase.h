@@ -0,0 +1,46 @@
+#ifndef __TIMEBASE_H__
+#define __TIMEBASE_H__
+
+/*_____ I N C L U D E S ____________________________________________________*/
+
+/*_____ D E C L A R A T I O N S ____________________________________________*/
+
+/*_____ D E F I N I T I O N S ______________________________________________*/
+
+/*
+	Timer1 mode 2 (8 bit auto-reload), FSYS / 12 = 2 MHz :
+	256 - 56 = 200 counts = 100 us
+
+	the hardware reloads TL1 from TH1 at the overflow, the ISR latency never enters the period :
+	zero cumulative error, the 500 ms / 1000 ms events are divided (through 1 ms) from the same overflow
+*/
+#define TIMEBASE_TICK_US            (100U)
+#define TIMEBASE_COUNTS             (200U)      /* Timer1 counts per tick, 0.5 us each */
+#define TIMEBASE_RELOAD             (256U - TIMEBASE_COUNTS)
+
+#define TIMEBASE_TICKS_PER_MS       (1000U / TIMEBASE_TICK_US)
+
+/* one flag byte per event : the ISR sets it, the main loop reads and clears it,
+   no read-modify-write on shared bits, no interrupt masking */
+typedef struct _timebase_manager_t
+{
+    unsigned char sub_div;          /* 100us ticks inside the current ms */
+    unsigned int div_500ms;         /* ms inside the current 500 ms */
+    unsigned char half_sec;         /* 1: second half of the current second */
+    unsigned char evt_500ms;        /* 1: 500 ms elapsed, cleared by the main loop */
+    unsigned char evt_1000ms;       /* 1: 1000 ms elapsed, cleared by the main loop */
+}TIMEBASE_MANAGER_T;
+
+extern volatile TIMEBASE_MANAGER_T g_TimebaseManager;
+
+/*_____ M A C R O S ________________________________________________________*/
+
+/* position inside the current 100us tick, 0 .. TIMEBASE_COUNTS - 1 (0.5 us) ; ISR side, Timer1 level */
+#define TIMEBASE_SUBTICK()          ((unsigned char)(TL1 - TIMEBASE_RELOAD))
+
+/*_____ F U N C T I O N S __________________________________________________*/
+
+/* Timer1 mode 2, 100us, ISR level 3 (same as the edge ISR) */
+void Timebase_Init(void);
+
+#endif //__TIMEBASE_H__
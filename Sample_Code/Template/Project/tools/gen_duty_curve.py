@@ -0,0 +1,83 @@
+#!/usr/bin/env python3
+"""
+Generate duty_curve.h : command -> output duty lookup tables in CODE memory.
+
+    command 0..100 %  ->  output duty 0..10000 (0.01 %, DUTY_RESOLUTION_HI)
+
+    gamma      : out = cmd ^ gamma                           (perceptual dimming)
+    sine power : out = phase x with P(x) = x - sin(2 pi x) / (2 pi) = cmd
+                 (power of a resistive load conducting x of a sine half wave,
+                  same for leading and trailing edge)
+
+manual step, not part of the Keil build : run it after changing a curve and
+commit the regenerated duty_curve.h with the change (from the Project folder) :
+    python tools/gen_duty_curve.py [--gamma 2.2] [--out duty_curve.h]
+"""
+
+import argparse
+import math
+import os
+
+POINTS = 101            # 0..100 %
+FULL = 10000            # DUTY_RESOLUTION_HI
+
+
+def gamma_table(gamma):
+    return [int(round(((i / 100.0) ** gamma) * FULL)) for i in range(POINTS)]
+
+
+def sine_power(x):
+    return x - math.sin(2.0 * math.pi * x) / (2.0 * math.pi)
+
+
+def sine_power_table():
+    table = []
+    for i in range(POINTS):
+        target = i / 100.0
+        lo, hi = 0.0, 1.0
+        for _ in range(60):                 # bisection, P(x) is monotonic on 0..1
+            mid = (lo + hi) / 2.0
+            if sine_power(mid) < target:
+                lo = mid
+            else:
+                hi = mid
+        table.append(int(round(((lo + hi) / 2.0) * FULL)))
+    return table
+
+
+def c_table(name, values):
+    lines = []
+    for i in range(0, len(values), 10):
+        chunk = ", ".join("%5uU" % v for v in values[i:i + 10])
+        lines.append("    " + chunk + ("," if i + 10 < len(values) else ""))
+    return ("static unsigned int code %s[DUTY_CURVE_POINTS] =\n{\n%s\n};\n"
+            % (name, "\n".join(lines)))
+
+
+def main():
+    here = os.path.dirname(os.path.abspath(__file__))
+    ap = argparse.ArgumentParser(description="generate duty_curve.h")
+    ap.add_argument("--gamma", type=float, default=2.2)
+    ap.add_argument("--out", default=os.path.join(here, "..", "duty_curve.h"))
+    args = ap.parse_args()
+
+    text = []
+    text.append("/* generated by tools/gen_duty_curve.py --gamma %.2f , do not edit */\n" % args.gamma)
+    text.append("/* command 0..100 %% -> output duty 0..%u, include from detect_pulse.c only */\n" % FULL)
+    text.append("#ifndef __DUTY_CURVE_H__\n#define __DUTY_CURVE_H__\n\n")
+    text.append("#define DUTY_CURVE_POINTS           (%uU)\n\n" % POINTS)
+    text.append("#if (DETECT_DUTY_CURVE == DUTY_CURVE_GAMMA)\n")
+    text.append("/* out = cmd ^ %.2f */\n" % args.gamma)
+    text.append(c_table("duty_curve_table", gamma_table(args.gamma)))
+    text.append("#elif (DETECT_DUTY_CURVE == DUTY_CURVE_SINE_POWER)\n")
+    text.append("/* conduction phase giving cmd of the full half wave power, resistive load */\n")
+    text.append(c_table("duty_curve_table", sine_power_table()))
+    text.append("#endif\n\n#endif /* __DUTY_CURVE_H__ */\n")
+
+    data = "".join(text)
+    with open(args.out, "w", newline="\n") as f:
+        f.write(data)
+
+
+if __name__ == "__main__":
+    main()